@@ -4,10 +4,27 @@
 #include <string.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <stdint.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <math.h>
+#include <time.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 
 #define MAX_PROCESSES 1000  // Maximum number of processes supported
 #define BUFFER_SIZE 1024    // Buffer size for input/output
 
+// Bytes needed for "seq = [...]" holding n ids of up to 11 characters plus separators
+#define SEQUENCE_SPACE(n) (8 + 12 * (n) + 2)
+
 // Structure to represent a process in FCFS (First-Come-First-Serve) scheduling
 typedef struct {
     int process_id;             // Process ID
@@ -81,16 +98,537 @@ typedef struct {
     float predicted_cpu_burst;       // Predicted CPU burst time (used in exponential averaging)
     float predicted_remaining_time;  // Predicted remaining time (used in exponential averaging)
     bool completed;                  // Flag to check if the process is completed
+    int prediction_version;          // Version of the pid's prediction the two fields above reflect
+    int prediction_slot;             // Index of the pid's entry in the prediction table
 } Process_For_SRT;
 
+// Ways of predicting the next CPU burst of a pid in SRT
+typedef enum {
+    PREDICTOR_EXPONENTIAL,           // tau = alpha * burst + (1 - alpha) * tau
+    PREDICTOR_WINDOW,                // Mean of the last few bursts
+    PREDICTOR_HOLT                   // Exponential smoothing with a trend term (alpha, beta)
+} Predictor_Kind;
+
+#define PREDICTOR_WINDOW_MAX 64
+
+// Formats the results can be written in
+typedef enum {
+    OUTPUT_TABLE,                    // Sequence, ASCII table and averages, for people
+    OUTPUT_CSV,                      // One CSV line per pid, then the summary
+    OUTPUT_JSONL,                    // One JSON object per pid, then the summary
+    OUTPUT_BINARY                    // RESULT_MAGIC, Result_Records, then a Result_Summary
+} Output_Format;
+
+// Prediction state of one pid
+typedef struct {
+    float tau;                       // Predicted next CPU burst
+    float trend;                     // Holt: trend estimate
+    int version;                     // Bumped on every update, so rows notice stale copies
+    int count;                       // Bursts seen so far
+    long long window_sum;            // Window: sum of the bursts in window[]
+    int window[PREDICTOR_WINDOW_MAX];// Window: most recent bursts (ring buffer)
+} Burst_Prediction;
+
+// Per-pid prediction table, one entry per distinct pid (rows keep their entry's index)
+typedef struct {
+    Burst_Prediction *entries;
+    int count;
+} Prediction_Table;
+
+// A row's pid and index, sorted to give each distinct pid its table entry
+typedef struct {
+    int pid;
+    int index;
+} Pid_Slot;
+
+// Algorithm-neutral process row, used where rows have to outlive the
+// per-algorithm structs (incremental mode carries them between runs)
+typedef struct {
+    int process_id;                  // Process ID
+    int arrival_time;                // Arrival time of the process
+    int time_until_first_response;   // Time until first response
+    int burst_time;                  // CPU burst time
+    int start_time;                  // Time when the process starts execution
+    int completion_time;             // Time when the process finishes execution
+    int waiting_time;                // Waiting time
+    int response_time;               // Response time, as the algorithm computes it
+    int remaining_time;              // Remaining execution time
+    int optional_column;             // Fifth CSV column (priority, ...) if present
+    bool has_optional_column;        // Whether the row had a fifth column
+    int input_index;                 // Position of the row among the rows read this run
+    long long input_end;             // Byte offset just past the row's line in the input
+    int line_length;                 // Length of the row's line in bytes
+    uint64_t line_hash;              // Hash of the row's line
+} Process_For_Sim;
+
+// Structure holding one line of the results table, accumulated over every row of a pid
+typedef struct {
+    int arrival;          // Earliest arrival time (-1 until a row is seen)
+    int burst;            // Sum of CPU bursts
+    int start;            // Earliest start time (-1 until a row is seen)
+    int finish;           // Latest finish time (-1 until a row is seen)
+    int wait;             // Sum of waiting times
+    int response_time;    // Smallest response time (starts at the algorithm's sentinel)
+    float tau;            // SRT: predicted CPU burst for the next row of this pid
+} Pid_Summary;
+
+// Command line options given as --name value after the algorithm
+typedef struct {
+    const char *incremental_state;  // --incremental <file>: resume from the last quiescent point
+    const char *quanta;             // --quanta q0,q1,...: MLFQ quantum per level
+    int boost_period;               // --boost <ticks>: MLFQ priority boost period (0 = never)
+    int latency;                    // --latency <ticks>: CFS period shared by the runnable processes
+    uint64_t seed;                  // --seed <n>: seed for the randomised modes
+    Predictor_Kind predictor;       // --predictor exponential|window|holt: SRT burst predictor
+    int window;                     // --window <n>: bursts averaged by the window predictor
+    float beta;                     // --beta <b>: trend smoothing of the Holt predictor
+    int io_time;                    // --io <ticks>: rows sharing a pid are bursts with this I/O between (-1 = off)
+    int switch_cost;                // --cs-cost <ticks>: time to switch the CPU to a different process
+    int cache_refill;               // --cache-refill <ticks>: extra time when a preempted process resumes
+    bool stats;                     // --stats: print switch counts, idle time, utilization and throughput
+    bool pipeline;                  // --pipeline: parse, simulate and print on separate threads
+    const char *timeline;           // --timeline <file>: write every run slice to file
+    bool timeline_binary;           // --timeline-format json|bin: Chrome trace JSON or binary records
+    const char *serve;              // --serve <socket>: answer requests on a Unix socket instead of reading stdin
+    int workers;                    // --workers <n>: threads answering requests in server mode
+    Output_Format output;           // --format table|csv|jsonl|bin: how the results are written
+    bool quiet;                     // --quiet: no sequence and no per-pid rows, only the averages
+    long long replications;         // --replicate <n>: run the algorithms over n variants of the trace (0 = off)
+    bool fitted_variants;           // --variant bootstrap|fitted: how the variants are drawn
+    int threads;                    // --threads <n>: threads running replications (0 = one per CPU)
+    const char *cache;              // --cache <dir>: reuse results of the same input and command line (default $SCHEDULER_CACHE)
+    bool no_cache;                  // --no-cache: neither read nor write the result cache
+    bool cache_refresh;             // --cache-refresh: run again and replace the cached result
+    int cores;                      // --cores <n>: simulate n CPUs (0 = the single-CPU simulators)
+    bool per_core_queues;           // --runqueue global|percore: one shared ready queue or one per core
+    int balance_period;             // --balance <ticks>: per-core queues are evened out this often (0 = never)
+} Options;
+
+Options options = {.latency = 24, .seed = 1, .predictor = PREDICTOR_EXPONENTIAL, .window = 3, .beta = 0.5f, .io_time = -1,
+                   .workers = 4, .balance_period = 100};
+
+// Counters of the context-switch cost model, kept up to date by every simulator
+typedef struct {
+    int last_dispatched;    // Index of the process the CPU ran last (-1 = none yet)
+    long long switches;     // Dispatches of a different process than the last one
+    long long refills;      // Those that resumed a preempted process, which refills its cache
+    long long overhead;     // Time spent switching
+    long long busy;         // Time spent running bursts
+    long long jobs;         // Rows completed
+    int first_arrival;      // Earliest arrival of a completed row
+    int last_finish;        // Latest completion time
+    int cores;              // CPUs sharing the work (0 = one)
+} Cpu_Stats;
+
+_Thread_local Cpu_Stats cpu_stats = {.last_dispatched = -1};  // Per thread, for the server's workers
+
+// When false the simulators keep their completion sequence to themselves
+// (incremental mode prints one sequence covering earlier runs as well)
+bool sequence_output_enabled = true;
+
+// Function to print a finished sequence string unless output is suppressed
+void emit_sequence(const char *seq) {
+    if (sequence_output_enabled) {
+        printf("%s\n", seq);
+    }
+}
+
+// Function to charge for dispatching a process (an index into the simulator's array),
+// returning the time the switch takes; dispatching the process that ran last is free
+int charge_dispatch(int process, bool resumed) {
+    if (process == cpu_stats.last_dispatched) {
+        return 0;
+    }
+    cpu_stats.last_dispatched = process;
+    cpu_stats.switches++;
+
+    int cost = options.switch_cost;
+    if (resumed) {
+        // Its working set was evicted while other processes ran
+        cpu_stats.refills++;
+        cost += options.cache_refill;
+    }
+    cpu_stats.overhead += cost;
+    return cost;
+}
+
+// Function to give the CPU time available from the first arrival to the last completion
+long long cpu_capacity(void) {
+    long long span = (cpu_stats.jobs > 0) ? (long long)cpu_stats.last_finish - cpu_stats.first_arrival : 0;
+    return (cpu_stats.cores > 1) ? span * cpu_stats.cores : span;
+}
+
+// Function to record a completed row for the utilization and throughput figures
+void record_completion(int arrival, int burst, int finish) {
+    if (cpu_stats.jobs == 0 || arrival < cpu_stats.first_arrival) cpu_stats.first_arrival = arrival;
+    if (cpu_stats.jobs == 0 || finish > cpu_stats.last_finish) cpu_stats.last_finish = finish;
+    cpu_stats.busy += burst;
+    cpu_stats.jobs++;
+}
+
+// Function to print context switches, idle time, CPU utilization and throughput,
+// measured from the first arrival to the last completion
+void display_cpu_stats(void) {
+    if (options.output != OUTPUT_TABLE) {
+        return;  // The structured formats carry these in their summary
+    }
+    long long span = (cpu_stats.jobs > 0) ? (long long)cpu_stats.last_finish - cpu_stats.first_arrival : 0;
+    long long capacity = cpu_capacity();
+
+    printf("Context Switches: %lld\n", cpu_stats.switches);
+    printf("Cache Refills: %lld\n", cpu_stats.refills);
+    printf("Switch Overhead: %lld ms\n", cpu_stats.overhead);
+    printf("Idle Time: %lld ms\n", capacity - cpu_stats.busy - cpu_stats.overhead);
+    if (span > 0) {
+        printf("CPU Utilization: %.2f%%\n", 100.0 * cpu_stats.busy / capacity);
+        printf("Throughput: %.4f jobs/ms\n", (double)cpu_stats.jobs / span);
+    }
+}
+
+// Functions for the decision profiler
+//
+// Built with -DSCHED_PROFILE the simulators time each scheduling decision
+// with the cycle counter: SJF's find_shortest_process, Priority's
+// find_next_process, the selection scan in simulate_preemptive_srt, the
+// pointer walk in simulateRR, and the ready-queue pop of the multi-burst
+// engine. Each sample goes into a histogram per decision site, indexed by the
+// ready-set size and the cycles taken, both in power-of-two buckets. At exit
+// the histograms are written to stderr: for each ready-size bucket, the
+// number of decisions and the mean, median and 99th percentile cost, so the
+// scaling shows directly. The ready-set size is counted outside the timed
+// region, from a cursor over the rows (sorted by arrival) minus the rows
+// completed, so profiling adds no scan of its own. Timestamps come from rdtsc
+// on x86, the virtual counter on AArch64 and clock_gettime elsewhere. The
+// counter's own overhead (some tens of cycles on x86) is part of every
+// sample. Without SCHED_PROFILE the PROFILE_* macros compile to nothing.
+//
+//     gcc -O2 -pthread -DSCHED_PROFILE -o scheduler_profile schedulerFile.c -lm
+//     ./scheduler_profile SJF < trace.csv
+
+typedef enum {
+    PROFILE_SJF_SELECT,
+    PROFILE_PRIORITY_SELECT,
+    PROFILE_SRT_SCAN,
+    PROFILE_RR_WALK,
+    PROFILE_ENGINE_POP,
+    PROFILE_SITES
+} Profile_Site;
+
+#ifdef SCHED_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILE_UNIT "cycles (rdtsc)"
+#elif defined(__aarch64__)
+#define PROFILE_UNIT "ticks (cntvct_el0)"
+#else
+#define PROFILE_UNIT "ns (clock_gettime)"
+#endif
+
+#define PROFILE_READY_BUCKETS 33  // 0, then [2^k, 2^(k+1)) for k = 0..31
+#define PROFILE_COST_BUCKETS 64   // [2^k, 2^(k+1)), with 0 in the first
+
+const char *profile_site_names[PROFILE_SITES] = {
+    "find_shortest_process (SJF)", "find_next_process (Priority)", "simulate_preemptive_srt scan (SRT)",
+    "simulateRR pointer walk (RR)", "multi-burst ready-queue pop (--io, --pipeline)",
+};
+
+// Samples per site, ready-set bucket and cost bucket; atomic so the server's workers can share them
+_Atomic uint64_t profile_counts[PROFILE_SITES][PROFILE_READY_BUCKETS][PROFILE_COST_BUCKETS];
+_Atomic uint64_t profile_totals[PROFILE_SITES][PROFILE_READY_BUCKETS];  // Sum of costs
+
+// Function to read the cycle counter
+static inline uint64_t profile_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// Function to give the power-of-two bucket of a value (0 and 1 share bucket 0)
+static inline int profile_bucket(uint64_t value) {
+    return (value <= 1) ? 0 : 63 - __builtin_clzll(value);
+}
+
+// Function to add one decision's cost to its site's histogram
+void profile_record(Profile_Site site, uint64_t cost, long long ready) {
+    int row = (ready <= 0) ? 0 : 1 + profile_bucket((uint64_t)ready);
+    atomic_fetch_add_explicit(&profile_counts[site][row][profile_bucket(cost)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&profile_totals[site][row], cost, memory_order_relaxed);
+}
+
+// Function to count the rows of a classic simulator's array that have arrived by time, moving the
+// cursor on from where the last call left it; the rows must be sorted by arrival time and time
+// must not go back, given the address of the first row's arrival time and the row size
+static inline int profile_advance_arrived(const int *arrival, size_t stride, int n, int time, int *arrived) {
+    while (*arrived < n && *(const int *)((const char *)arrival + *arrived * stride) <= time) {
+        (*arrived)++;
+    }
+    return *arrived;
+}
+
+// Function to give the upper bound of the cost bucket holding the given fraction of a row's samples
+uint64_t profile_percentile(Profile_Site site, int row, uint64_t count, double fraction) {
+    uint64_t target = (uint64_t)ceil(fraction * count), seen = 0;
+    for (int bucket = 0; bucket < PROFILE_COST_BUCKETS; bucket++) {
+        seen += atomic_load_explicit(&profile_counts[site][row][bucket], memory_order_relaxed);
+        if (seen >= target) return (bucket >= 63) ? UINT64_MAX : (2ULL << bucket) - 1;
+    }
+    return UINT64_MAX;
+}
+
+// Function to write every site's histogram to stderr (registered with atexit)
+void profile_dump(void) {
+    for (int site = 0; site < PROFILE_SITES; site++) {
+        bool header = false;
+        for (int row = 0; row < PROFILE_READY_BUCKETS; row++) {
+            uint64_t count = 0;
+            for (int bucket = 0; bucket < PROFILE_COST_BUCKETS; bucket++) {
+                count += atomic_load_explicit(&profile_counts[site][row][bucket], memory_order_relaxed);
+            }
+            if (count == 0) continue;
+            if (!header) {
+                fprintf(stderr, "\nDecision profile: %s, %s\n", profile_site_names[site], PROFILE_UNIT);
+                fprintf(stderr, "  %-23s %12s %12s %10s %10s\n", "ready", "decisions", "mean", "p50 <=", "p99 <=");
+                header = true;
+            }
+            char range[32];
+            if (row == 0) snprintf(range, sizeof(range), "0");
+            else if (row == 1) snprintf(range, sizeof(range), "1");
+            else snprintf(range, sizeof(range), "%llu-%llu", 1ULL << (row - 1), (2ULL << (row - 1)) - 1);
+            fprintf(stderr, "  %-23s %12llu %12.1f %10llu %10llu\n", range, (unsigned long long)count,
+                    (double)atomic_load_explicit(&profile_totals[site][row], memory_order_relaxed) / count,
+                    (unsigned long long)profile_percentile(site, row, count, 0.5),
+                    (unsigned long long)profile_percentile(site, row, count, 0.99));
+        }
+    }
+}
+
+#define PROFILE_INIT() atexit(profile_dump)
+#define PROFILE_DECLARE(stamp) uint64_t stamp = 0
+#define PROFILE_START(stamp) ((stamp) = profile_cycles())
+#define PROFILE_START_ONCE(stamp) ((stamp) == 0 ? (void)((stamp) = profile_cycles()) : (void)0)
+#define PROFILE_STOP(site, stamp, ready) (profile_record((site), profile_cycles() - (stamp), (ready)), (stamp) = 0)
+#define PROFILE_DECLARE_CURSOR(arrived) int arrived = 0
+#define PROFILE_READY(rows, n, time, arrived, completed) \
+    (profile_advance_arrived(&(rows)[0].arrival_time, sizeof((rows)[0]), (n), (time), &(arrived)) - (completed))
+
+#else
+
+#define PROFILE_INIT() ((void)0)
+#define PROFILE_DECLARE(stamp)
+#define PROFILE_DECLARE_CURSOR(arrived)
+#define PROFILE_START(stamp) ((void)0)
+#define PROFILE_START_ONCE(stamp) ((void)0)
+#define PROFILE_STOP(site, stamp, ready) ((void)0)
+
+#endif
+
+// Functions for the timeline export
+//
+// With --timeline <file> every run slice (pid, start, end, core) is streamed
+// to the file through a fixed-size buffer, so memory stays the same however
+// long the run is. Back-to-back slices of one pid on one core are merged
+// before they are written, which turns SRT's one-tick steps into whole runs.
+// The default format is Chrome trace-event JSON (one "X" event per slice,
+// a tick shown as 1 ms) that Perfetto and chrome://tracing open directly;
+// --timeline-format bin writes TIMELINE_MAGIC and then one Timeline_Record of
+// four native-endian int32s per slice. Without --timeline a slice costs one test.
+
+#define TIMELINE_MAGIC "SCHEDTL1"
+#define TIMELINE_BUFFER_SIZE (1 << 16)
+
+// One run slice as written by the binary format
+typedef struct {
+    int32_t pid;
+    int32_t start;
+    int32_t end;
+    int32_t core;
+} Timeline_Record;
+
+typedef struct {
+    FILE *out;                  // NULL while no timeline is being written
+    bool binary;
+    bool first_event;           // JSON: no comma before the first event
+    bool has_pending;
+    Timeline_Record pending;    // Last slice, held back in case the next one continues it
+    size_t used;
+    char buffer[TIMELINE_BUFFER_SIZE];
+} Timeline_Writer;
+
+Timeline_Writer timeline;
+
+// Function to write out the timeline buffer
+void timeline_flush(void) {
+    if (timeline.used > 0 && fwrite(timeline.buffer, 1, timeline.used, timeline.out) != timeline.used) {
+        printf("Error: Could not write the timeline.\n");
+        exit(1);
+    }
+    timeline.used = 0;
+}
+
+// Function to append bytes to the timeline buffer, flushing it when full
+void timeline_write(const void *data, size_t length) {
+    if (timeline.used + length > TIMELINE_BUFFER_SIZE) {
+        timeline_flush();
+    }
+    memcpy(timeline.buffer + timeline.used, data, length);
+    timeline.used += length;
+}
+
+// "00" to "99", so numbers can be formatted two digits per division
+const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839404142434445464748495051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+// Function to write a 32-bit magnitude in decimal at out, returning the end of the digits
+char *format_small_decimal(char *out, uint32_t magnitude) {
+    int length = (magnitude < 10) ? 1 : (magnitude < 100) ? 2 : (magnitude < 1000) ? 3 : (magnitude < 10000) ? 4
+               : (magnitude < 100000) ? 5 : (magnitude < 1000000) ? 6 : (magnitude < 10000000) ? 7
+               : (magnitude < 100000000) ? 8 : (magnitude < 1000000000) ? 9 : 10;
+    char *last = out + length;
+    while (magnitude >= 100) {
+        last -= 2;
+        memcpy(last, digit_pairs + 2 * (magnitude % 100), 2);
+        magnitude /= 100;
+    }
+    if (magnitude >= 10) {
+        memcpy(last - 2, digit_pairs + 2 * magnitude, 2);
+    } else {
+        last[-1] = (char)('0' + magnitude);
+    }
+    return out + length;
+}
+
+// Function to write value in decimal at out, returning the end of the digits
+// (snprintf is most of the cost of a multi-million event JSON timeline)
+char *format_decimal(char *out, long long value) {
+    unsigned long long magnitude = (value < 0) ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    if (value < 0) {
+        *out++ = '-';
+    }
+    if (magnitude <= UINT32_MAX) {
+        return format_small_decimal(out, (uint32_t)magnitude);  // Every int, with 32-bit arithmetic
+    }
+
+    // Longer numbers are rare, one digit at a time
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0);
+    while (count > 0) {
+        *out++ = digits[--count];
+    }
+    return out;
+}
+
+// Function to copy a string literal's text to out, returning the end
+char *format_text(char *out, const char *text) {
+    size_t length = strlen(text);
+    memcpy(out, text, length);
+    return out + length;
+}
+
+// Function to write one slice in the chosen format
+void timeline_emit(const Timeline_Record *record) {
+    if (timeline.binary) {
+        timeline_write(record, sizeof(*record));
+        return;
+    }
+    char event[160];
+    char *end = event;
+    end = format_text(end, timeline.first_event ? "{\"name\":\"pid " : ",\n{\"name\":\"pid ");
+    end = format_decimal(end, record->pid);
+    end = format_text(end, "\",\"ph\":\"X\",\"pid\":1,\"tid\":");
+    end = format_decimal(end, record->core);
+    end = format_text(end, ",\"ts\":");
+    end = format_decimal(end, (long long)record->start * 1000);
+    end = format_text(end, ",\"dur\":");
+    end = format_decimal(end, ((long long)record->end - record->start) * 1000);
+    *end++ = '}';
+    timeline.first_event = false;
+    timeline_write(event, end - event);
+}
+
+// Function to start writing a timeline to path
+void timeline_open(const char *path, bool binary) {
+    timeline.out = fopen(path, "wb");
+    if (timeline.out == NULL) {
+        printf("Error: Could not open timeline file '%s'.\n", path);
+        exit(1);
+    }
+    timeline.binary = binary;
+    timeline.first_event = true;
+    timeline.has_pending = false;
+    timeline.used = 0;
+    if (binary) {
+        timeline_write(TIMELINE_MAGIC, strlen(TIMELINE_MAGIC));
+    } else {
+        const char *header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+                             "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"CPU\"}}";
+        timeline_write(header, strlen(header));
+        timeline.first_event = false;
+    }
+}
+
+// Function to add a slice, merging it into the previous one when it carries straight on
+void timeline_append(int pid, int start, int end, int core) {
+    Timeline_Record *pending = &timeline.pending;
+    if (timeline.has_pending && pending->pid == pid && pending->core == core && pending->end == start) {
+        pending->end = end;
+        return;
+    }
+    if (timeline.has_pending) {
+        timeline_emit(pending);
+    }
+    pending->pid = pid;
+    pending->start = start;
+    pending->end = end;
+    pending->core = core;
+    timeline.has_pending = true;
+}
+
+// Function to record that pid ran on core from start to end, if a timeline is being written
+void timeline_slice(int pid, int start, int end, int core) {
+    if (timeline.out != NULL && end > start) {
+        timeline_append(pid, start, end, core);
+    }
+}
+
+// Function to finish the timeline file (registered with atexit)
+void timeline_close(void) {
+    if (timeline.out == NULL) {
+        return;
+    }
+    if (timeline.has_pending) {
+        timeline_emit(&timeline.pending);
+    }
+    if (!timeline.binary) {
+        timeline_write("\n]}\n", 4);
+    }
+    timeline_flush();
+    fclose(timeline.out);
+    timeline.out = NULL;
+}
+
 // Function to print the process values after FCFS simulation
 void print_values(Process_For_FCFS processes[], int n) {
     int total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0; // Aggregates for averages
 
     // Print header for table
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
-    printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
 
     // Iterate through the processes
     for (int i = 1; i <= 50; i++) {
@@ -133,14 +671,16 @@ void print_values(Process_For_FCFS processes[], int n) {
         total_response_time += response_time;
 
         // Print process values
-        printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",
-               id, arrival, burst, start, finish, wait, turnaround, response_time);
+        if (!options.quiet) {
+            printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",
+                   id, arrival, burst, start, finish, wait, turnaround, response_time);
+        }
     }
     
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
 
     // Print average wait, turnaround, and response times
-    printf("\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
     printf("Average Turnaround Time: %.2f ms\n", (float)total_turnaround_time / n);
     printf("Average Response Time: %.2f ms\n", (float)total_response_time / n);
 }
@@ -167,7 +707,7 @@ void simulate_fcfs(Process_For_FCFS processes[], int n) {
     int current_time = 0;  // Tracks the current time
     int total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0; // Totals for averages
 
-    int space_required = (2 * n) + 1;  // Space required for sequence string
+    int space_required = SEQUENCE_SPACE(n);  // Space required for sequence string
     char *seq = (char *)malloc(space_required * sizeof(char));  // Allocate memory for sequence
     if (seq == NULL) {
         printf("Memory allocation failed\n");
@@ -185,6 +725,7 @@ void simulate_fcfs(Process_For_FCFS processes[], int n) {
             }
         }
 
+        current_time += charge_dispatch(i, false);  // Switch to the process
         processes[i].start_time = current_time;  // Set start time for process
 
         // Execute the burst time for the process
@@ -193,6 +734,8 @@ void simulate_fcfs(Process_For_FCFS processes[], int n) {
         }
 
         processes[i].finish_time = processes[i].start_time + processes[i].burst_time;  // Set finish time
+        record_completion(processes[i].arrival_time, processes[i].burst_time, processes[i].finish_time);
+        timeline_slice(processes[i].process_id, processes[i].start_time, processes[i].finish_time, 0);
 
         if (current_time != processes[i].finish_time) {
             printf("Error: current_time != processes[i].finish_time\n");
@@ -215,10 +758,8 @@ void simulate_fcfs(Process_For_FCFS processes[], int n) {
 
     // Close sequence string and print it
     strcat(seq, "]");
-    printf("%s\n", seq);
+    emit_sequence(seq);
     free(seq);  // Free allocated memory
-
-    print_values(processes, n);  // Print process values and averages
 }
 
 // Function to sort processes with the same arrival time in SJF scheduling
@@ -263,7 +804,7 @@ void simulateSPN(Process_For_SJF processes[], int n) {
     int total_waiting_time = 0, total_turnaround_time = 0, total_response_time = 0;  // Totals for averages
 
     // Memory allocation for sequence output
-    int space_required = (2 * n) + 1;  // Space required for sequence string
+    int space_required = SEQUENCE_SPACE(n);  // Space required for sequence string
     char *seq = (char *)malloc(space_required * sizeof(char));  // Allocate memory
     if (seq == NULL) {
         printf("Memory allocation failed\n");
@@ -273,13 +814,18 @@ void simulateSPN(Process_For_SJF processes[], int n) {
     strcpy(seq, "seq = [");  // Initialize sequence string
 
     // Simulate SJF scheduling
+    PROFILE_DECLARE(decision_start);
+    PROFILE_DECLARE_CURSOR(profile_arrived);
     while (completed_processes < n) {
+        PROFILE_START(decision_start);
         int index = find_shortest_process(processes, n, current_time);  // Find the next shortest process
+        PROFILE_STOP(PROFILE_SJF_SELECT, decision_start, PROFILE_READY(processes, n, current_time, profile_arrived, completed_processes));
 
         if (index != -1) {  // If a process is ready to execute
             Process_For_SJF *current_process = &processes[index];
 
-            // Set the start time of the process
+            // Switch to the process and set its start time
+            current_time += charge_dispatch(index, false);
             current_process->start_time = current_time;
 
             // Execute the process (advance current time by its burst time)
@@ -290,6 +836,8 @@ void simulateSPN(Process_For_SJF processes[], int n) {
 
             current_process->finished = true;  // Mark the process as finished
             current_process->completion_time = current_time;  // Set the completion time
+            record_completion(current_process->arrival_time, current_process->burst_time, current_time);
+            timeline_slice(current_process->process_id, current_process->start_time, current_time, 0);
 
             // Append the process ID to the sequence string
             char str[20];
@@ -308,7 +856,7 @@ void simulateSPN(Process_For_SJF processes[], int n) {
     }
 
     strcat(seq, "]");  // Close the sequence string
-    printf("%s\n", seq);  // Print the sequence
+    emit_sequence(seq);  // Print the sequence
     free(seq);  // Free allocated memory
 }
 
@@ -317,9 +865,11 @@ void display_and_calculate_averages_sjf(Process_For_SJF processes[], int n) {
     int total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0;  // Totals for averages
 
     // Print header for process details
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
-    printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
 
     // Loop through each process
     for (int i = 1; i <= 50; i++) {
@@ -347,13 +897,13 @@ void display_and_calculate_averages_sjf(Process_For_SJF processes[], int n) {
         total_response_time += response_time;
 
         // Print process details
-        printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n", id, arrival, burst, start, finish, wait, turnaround, response_time);
+        if (!options.quiet) printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n", id, arrival, burst, start, finish, wait, turnaround, response_time);
     }
 
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
 
     // Print average times
-    printf("\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
     printf("Average Turnaround Time: %.2f ms\n", (float)total_turnaround_time / n);
     printf("Average Response Time: %.2f ms\n", (float)total_response_time / n);
 }
@@ -403,7 +953,7 @@ void calculate_times(Process_For_Priority process[], int n) {
     int completed_processes = 0;
 
     // Memory allocation for sequence output
-    int space_required = (2 * n) + 1;
+    int space_required = SEQUENCE_SPACE(n);
     char *seq = (char *)malloc(space_required * sizeof(char));
     if (seq == NULL) {
         printf("Memory allocation failed\n");
@@ -412,15 +962,22 @@ void calculate_times(Process_For_Priority process[], int n) {
 
     strcpy(seq, "seq = [");  // Initialize sequence string
 
+    PROFILE_DECLARE(decision_start);
+    PROFILE_DECLARE_CURSOR(profile_arrived);
     while (completed_processes < n) {
         // Find the next process to execute based on priority
+        PROFILE_START(decision_start);
         int next_process_index = find_next_process(process, n, current_time);
+        PROFILE_STOP(PROFILE_PRIORITY_SELECT, decision_start, PROFILE_READY(process, n, current_time, profile_arrived, completed_processes));
 
         if (next_process_index == -1) {
             current_time++;  // Increment time if no process is ready
             continue;
         }
 
+        // Switch to the process
+        current_time += charge_dispatch(next_process_index, false);
+
         // Set the start time of the process
         if (process[next_process_index].start_time == -1) {
             process[next_process_index].start_time = current_time;
@@ -433,6 +990,8 @@ void calculate_times(Process_For_Priority process[], int n) {
 
         // Set completion time
         process[next_process_index].completion_time = current_time;
+        record_completion(process[next_process_index].arrival_time, process[next_process_index].burst_time, current_time);
+        timeline_slice(process[next_process_index].process_id, current_time - process[next_process_index].burst_time, current_time, 0);
 
         // Calculate turnaround, waiting, and response times
         process[next_process_index].turn_around_time = process[next_process_index].completion_time - process[next_process_index].arrival_time;
@@ -454,7 +1013,7 @@ void calculate_times(Process_For_Priority process[], int n) {
     }
 
     strcat(seq, "]");  // Close sequence string
-    printf("%s\n", seq);  // Print sequence
+    emit_sequence(seq);  // Print sequence
     free(seq);  // Free allocated memory
 }
 
@@ -463,9 +1022,11 @@ void display_and_calculate_averages_priority(Process_For_Priority processes[], i
     int total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0;  // Totals for averages
 
     // Print header for process details
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
-    printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
 
     // Loop through each process
     for (int i = 1; i <= 50; i++) {
@@ -493,13 +1054,13 @@ void display_and_calculate_averages_priority(Process_For_Priority processes[], i
         total_response_time += response_time;
 
         // Print process details
-        printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n", id, arrival, burst, start, finish, wait, turnaround, response_time);
+        if (!options.quiet) printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n", id, arrival, burst, start, finish, wait, turnaround, response_time);
     }
 
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
 
     // Print average times
-    printf("\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
     printf("Average Turnaround Time: %.2f ms\n", (float)total_turnaround_time / n);
     printf("Average Response Time: %.2f ms\n", (float)total_response_time / n);
 }
@@ -517,7 +1078,7 @@ void simulateRR( Process_For_RR process[], int n, int q) {
     int total_waiting_time = 0, total_turnaround_time = 0, total_response_time = 0;
     int current_time = 0, completed = 0;
     
-    int space_required = (2 * n) + 1 ;
+    int space_required = SEQUENCE_SPACE(n);
 
     char *seq = (char *)malloc(space_required * sizeof(char));
     if (seq == NULL) {
@@ -531,6 +1092,7 @@ void simulateRR( Process_For_RR process[], int n, int q) {
      
     int top = 0, bottom = 0, pointer = 0;  // Front and bottom pointers for the queue
     pointer = top;
+    PROFILE_DECLARE(walk_start);
 
      // Add the first process that arrives at time 0
      for (int i = 0; i < n; i++) {
@@ -542,12 +1104,12 @@ void simulateRR( Process_For_RR process[], int n, int q) {
      while (completed < n) {
         
 
-        if (top == bottom) {
+        if (top == bottom || completed == bottom) {
              // No process in the ready queue, move time forward to the next process arrival
-             // in the case where there is one process what do we do 
+             // (also once every admitted process has finished, or the pointer spins forever)
              current_time++; 
             
-            for (int i = 0; i < n; i++) {
+            for (int i = bottom; i < n; i++) {
                 if (process[i].arrival_time <= current_time) { 
                     bottom++;
                     
@@ -560,6 +1122,8 @@ void simulateRR( Process_For_RR process[], int n, int q) {
 
         
 
+        // The walk to the next unfinished process is one decision, however many rows it skips
+        PROFILE_START_ONCE(walk_start);
         if(process[pointer].completed == true){
 
             if (pointer >= bottom-1){
@@ -575,6 +1139,19 @@ void simulateRR( Process_For_RR process[], int n, int q) {
 
 
 
+         PROFILE_STOP(PROFILE_RR_WALK, walk_start, bottom - completed);
+
+         // Switching to a different process takes time, and arrivals still join meanwhile
+         int switch_time = charge_dispatch(pointer, process[pointer].start_time != -1);
+         for (int k = 0; k < switch_time; k++) {
+             current_time++;
+             for (int i = bottom; i < n; i++) {
+                 if (process[i].arrival_time <= current_time) {
+                     bottom++;
+                 }
+             }
+         }
+
          // If it's the first time the process is executing, calculate its response time
          if (process[pointer].start_time == -1) {
             process[pointer].start_time = current_time;
@@ -619,12 +1196,15 @@ void simulateRR( Process_For_RR process[], int n, int q) {
         }
 
 
+         timeline_slice(process[pointer].process_id, current_time - time_slice, current_time, 0);
+
          // Check if the process is completed
          if (process[pointer].remaining_time == 0) {
              process[pointer].completion_time = current_time;
              process[pointer].turn_around_time = process[pointer].completion_time - process[pointer].arrival_time;
              process[pointer].waiting_time = process[pointer].turn_around_time - process[pointer].burst_time;
              process[pointer].completed= true;
+             record_completion(process[pointer].arrival_time, process[pointer].burst_time, current_time);
 
             char str[20];  // Buffer to hold the string
             sprintf(str, "%d", process[pointer].process_id);
@@ -647,7 +1227,7 @@ void simulateRR( Process_For_RR process[], int n, int q) {
      }
 
         strcat(seq, "]");
-        printf("%s\n", seq);
+        emit_sequence(seq);
         free(seq);
     }
 
@@ -678,9 +1258,11 @@ void display_and_calculate_averages_RR(Process_For_RR processes[], int n){
     int total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0; // not sure if i will actually need these 
 
 
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
-    printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
 
     for (int i = 1; i <= 50; i++){
 
@@ -739,15 +1321,15 @@ void display_and_calculate_averages_RR(Process_For_RR processes[], int n){
         total_turnaround_time += turnaround;
         total_response_time += response_time;
 
-        printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",id,arrival,burst,start ,finish, wait ,turnaround , response_time); 
+        if (!options.quiet) printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",id,arrival,burst,start ,finish, wait ,turnaround , response_time); 
         
   
 }
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
 
 
 
-    printf("\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
     printf("Average Turnaround Time: %.2f ms\n", (float)total_turnaround_time / n);
     printf("Average Response Time: %.2f ms\n", (float)total_response_time /n);
 
@@ -764,9 +1346,11 @@ void display_and_calculate_averages_srt(Process_For_SRT processes[], int n){
 
 
 
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
-    printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
 
     for (int i = 1; i <= 50; i++){
 
@@ -825,26 +1409,104 @@ void display_and_calculate_averages_srt(Process_For_SRT processes[], int n){
         total_turnaround_time += turnaround;
         total_response_time += response_time;
 
-        printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",id,arrival,burst,start ,finish, wait ,turnaround , response_time); 
+        if (!options.quiet) printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n",id,arrival,burst,start ,finish, wait ,turnaround , response_time); 
   
 }
-    printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    if (!options.quiet) printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
 
 
 
-    printf("\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", (float)total_wait_time / n);
     printf("Average Turnaround Time: %.2f ms\n", (float)total_turnaround_time / n);
     printf("Average Response Time: %.2f ms\n", (float)total_response_time / n);
 
 
 }
 
+// Function to order Pid_Slots by pid, then by row
+int compare_pid_slots(const void *a, const void *b) {
+    const Pid_Slot *x = (const Pid_Slot *)a, *y = (const Pid_Slot *)b;
+    if (x->pid != y->pid) return (x->pid > y->pid) - (x->pid < y->pid);
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+// Function to build the prediction table for the pids in processes[]. Each pid
+// starts from the predicted_cpu_burst of its first row (10 from main). Entries
+// are numbered by sorting the pids, so far-apart pids cost nothing extra.
+Prediction_Table create_prediction_table(Process_For_SRT processes[], int n) {
+    Prediction_Table table = {NULL, 0};
+    if (n == 0) {
+        return table;
+    }
+
+    Pid_Slot *slots = (Pid_Slot *)malloc(n * sizeof(Pid_Slot));
+    table.entries = (Burst_Prediction *)calloc(n, sizeof(Burst_Prediction));
+    if (slots == NULL || table.entries == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        slots[i].pid = processes[i].process_id;
+        slots[i].index = i;
+    }
+    qsort(slots, n, sizeof(Pid_Slot), compare_pid_slots);
+    for (int k = 0; k < n; k++) {
+        Process_For_SRT *process = &processes[slots[k].index];
+        if (k == 0 || slots[k].pid != slots[k - 1].pid) {
+            table.entries[table.count++].tau = process->predicted_cpu_burst;
+        }
+        process->prediction_slot = table.count - 1;
+        process->prediction_version = 0;
+    }
+    free(slots);
+    return table;
+}
+
+// Function to feed a finished burst into its pid's prediction
+void update_prediction(Burst_Prediction *entry, int actual_burst, float alpha) {
+    switch (options.predictor) {
+    case PREDICTOR_EXPONENTIAL:
+        entry->tau = (alpha * actual_burst) + ((1 - alpha) * entry->tau);
+        break;
+    case PREDICTOR_WINDOW: {
+        int slot = entry->count % options.window;
+        if (entry->count >= options.window) entry->window_sum -= entry->window[slot];
+        entry->window[slot] = actual_burst;
+        entry->window_sum += actual_burst;
+        int samples = (entry->count + 1 < options.window) ? entry->count + 1 : options.window;
+        entry->tau = (float)entry->window_sum / samples;
+        break;
+    }
+    case PREDICTOR_HOLT: {
+        // The prediction is level + trend, so recover the level before updating it
+        float level = entry->tau - entry->trend;
+        float new_level = (alpha * actual_burst) + ((1 - alpha) * (level + entry->trend));
+        entry->trend = (options.beta * (new_level - level)) + ((1 - options.beta) * entry->trend);
+        entry->tau = new_level + entry->trend;
+        break;
+    }
+    }
+    entry->count++;
+    entry->version++;
+}
+
+// Function to bring a row's predicted burst and remaining time up to date with its pid's entry
+void sync_prediction(Process_For_SRT *process, const Prediction_Table *table) {
+    const Burst_Prediction *entry = &table->entries[process->prediction_slot];
+    if (process->prediction_version != entry->version) {
+        process->predicted_cpu_burst = (float) entry->tau;
+        int time_ran = process->actual_cpu_burst - process->remaining_time;
+        process->predicted_remaining_time = (float)process->predicted_cpu_burst - time_ran;
+        process->prediction_version = entry->version;
+    }
+}
+
 void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, float alpha) {
     int time = 0;            // Global simulation time
     int completed = 0;       // Number of processes completed
     int current_process = -1; // Currently running process
 
-    int space_required = (2 * num_processes) + 1 ;
+    int space_required = SEQUENCE_SPACE(num_processes);
     char *seq = (char *)malloc(space_required * sizeof(char));
     if (seq == NULL) {
         printf("Memory allocation failed\n");
@@ -852,21 +1514,27 @@ void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, flo
     // Initialize the string
     strcpy(seq, "seq = [");
 
+    // One prediction per pid; rows pick up changes the next time they are looked at
+    Prediction_Table predictions = create_prediction_table(processes, num_processes);
 
-
+    PROFILE_DECLARE(decision_start);
+    PROFILE_DECLARE_CURSOR(profile_arrived);
     while (completed < num_processes) {
         int shortest_index = -1;
         float shortest_time = __FLT_MAX__;
 
         // Find the process with the shortest remaining time that has arrived and is not completed
+        PROFILE_START(decision_start);
         for (int i = 0; i < num_processes; i++) {
             if (processes[i].arrival_time <= time && !processes[i].completed) {
+                sync_prediction(&processes[i], &predictions);
                 if (processes[i].predicted_remaining_time < shortest_time) {
                     shortest_time = processes[i].predicted_remaining_time;
                     shortest_index = i;
                 }
             }
         }
+        PROFILE_STOP(PROFILE_SRT_SCAN, decision_start, PROFILE_READY(processes, num_processes, time, profile_arrived, completed));
 
 
         // If no process can run, advance time
@@ -877,7 +1545,14 @@ void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, flo
 
         // If a new process has arrived with shorter remaining time, preempt the current process
         if (current_process != shortest_index) {
-            
+
+            // Switching takes time; arrivals during it are compared before the process runs
+            int switch_time = charge_dispatch(shortest_index, processes[shortest_index].start_time != -1);
+            if (switch_time > 0) {
+                time += switch_time;
+                continue;
+            }
+
             current_process = shortest_index;
 
             // Record the first response time for the new process
@@ -890,6 +1565,7 @@ void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, flo
         processes[current_process].remaining_time--;
         processes[current_process].predicted_remaining_time--;
         time++;
+        timeline_slice(processes[current_process].process_id, time - 1, time, 0);
 
 
 
@@ -899,6 +1575,7 @@ void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, flo
             completed++;
             processes[current_process].completed=true;
             processes[current_process].finish_time = time;
+            record_completion(processes[current_process].arrival_time, processes[current_process].actual_cpu_burst, time);
 
 
             char str[20];  // Buffer to hold the string
@@ -919,30 +1596,19 @@ void simulate_preemptive_srt(Process_For_SRT processes[], int num_processes, flo
            
 
 
-            // Update prediction using exponential averaging - do we update for the next one or all of the follwoing process 
-            // all process that have not yet arrived  
+            // Update the pid's prediction; every row of the pid, arrived or not, sees the
+            // new value through sync_prediction, so this is O(1) instead of a pass over all rows
             int actual_burst = processes[current_process].actual_cpu_burst;
-            float tau_next = (alpha * actual_burst) + ((1 - alpha) * processes[current_process].predicted_cpu_burst);
-
-            // updatea all the ones that have not arrived yet
+            update_prediction(&predictions.entries[processes[current_process].prediction_slot], actual_burst, alpha);
 
-            for (int i = 0; i < num_processes; i++) {
-
-                // do we change the tau for the ones that have not even arrived yet or does also cahged the taou for the ones that have arrived already 
-                if (processes[i].process_id == processes[current_process].process_id ) {
-                    processes[i].predicted_cpu_burst = (float) tau_next;
-                    int time_ran =  processes[i].actual_cpu_burst - processes[i].remaining_time; 
-                    processes[i].predicted_remaining_time = (float)processes[i].predicted_cpu_burst - time_ran;
-                    
-                }
-            }
             current_process = -1;  // Reset current process since it has finished
         }
     }
 
         strcat(seq, "]");
-        printf("%s\n", seq);
+        emit_sequence(seq);
         free(seq);
+        free(predictions.entries);
 }
 
 void sort_same_arrival_time_processes_SRT(Process_For_SRT processes[], int n){
@@ -967,108 +1633,4888 @@ void sort_same_arrival_time_processes_SRT(Process_For_SRT processes[], int n){
 }
 
 
+// Functions for incremental re-simulation
+//
+// A trace that only ever grows can not change the schedule before the last
+// point where the ready queue ran empty: every row that arrived before it
+// has finished, and every later row arrives after it. Incremental mode keeps
+// the results up to that quiescent point in a state file (the byte offset
+// reached in the trace, the completion sequence and the per-pid table) and
+// on the next run only reads and simulates the rows after it, with time
+// shifted so the simulators start at zero instead of ticking up to it.
 
+#define INCREMENTAL_MAGIC "SCHEDINC"
+#define INCREMENTAL_VERSION 1
+#define HASH_SEED 1469598103934665603ULL  // FNV-1a offset basis
 
-int main(int argc, char *argv[]) {
-    // Check if there are more than 3 arguments or no algorithm is specified
-    if (argc > 3) {
-        printf("Error: No scheduling algorithm specified.\n");
-        return 1;
+// Header of the incremental state file, followed by the sequence and the pid table
+typedef struct {
+    char magic[8];                 // INCREMENTAL_MAGIC
+    int version;                   // INCREMENTAL_VERSION
+    char algorithm[16];            // Algorithm the state was built with
+    float parameter;               // RR quantum or SRT alpha (0 for the others)
+    int quiescent_time;            // Last time the ready queue was empty
+    int rows;                      // Rows folded into the state
+    int sequence_length;           // Entries in the saved completion sequence
+    int pid_count;                 // Entries in the pid table
+    int check_length;              // Length of the trace line ending at input_offset
+    long long input_offset;        // Bytes of the trace consumed up to the quiescent point
+    uint64_t check_hash;           // Hash of that line, to notice a rewritten trace
+} Incremental_Header;
+
+typedef struct {
+    Incremental_Header header;
+    int *sequence;                 // Completion order of the rows folded in so far
+    Pid_Summary *pids;             // Per-pid table over the rows folded in so far
+} Incremental_State;
+
+// Function to hash a block of bytes (FNV-1a)
+uint64_t hash_bytes(const void *data, size_t length, uint64_t hash) {
+    const unsigned char *bytes = (const unsigned char *)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
     }
+    return hash;
+}
 
-    // If the scheduling algorithm is FCFS (First Come First Serve)
-    if (strcmp(argv[1], "FCFS") == 0) {
-        Process_For_FCFS processes[MAX_PROCESSES];  // Array to store processes
-        int n = 0;  // Number of processes
-        
-        char buffer[BUFFER_SIZE];  // Buffer to read input
+// Function to return the value a display function starts its response minimum at
+// (-2 if the algorithm is unknown)
+int response_sentinel(const char *algorithm) {
+    if (strcmp(algorithm, "FCFS") == 0 || strcmp(algorithm, "SJF") == 0 || strcmp(algorithm, "SRT") == 0) {
+        return 0;
+    }
+    if (strcmp(algorithm, "Priority") == 0 || strcmp(algorithm, "RR") == 0) {
+        return -1;
+    }
+    return -2;
+}
 
-        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
+// Function to make room in the pid table for pid, initialising new entries
+Pid_Summary *grow_pid_summaries(Pid_Summary *pids, int *pid_count, int pid, int sentinel) {
+    if (pid < *pid_count) {
+        return pids;
+    }
+    int new_count = (pid + 1 > 2 * *pid_count) ? pid + 1 : 2 * *pid_count;
+    pids = (Pid_Summary *)realloc(pids, new_count * sizeof(Pid_Summary));
+    if (pids == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = *pid_count; i < new_count; i++) {
+        pids[i].arrival = -1;
+        pids[i].burst = 0;
+        pids[i].start = -1;
+        pids[i].finish = -1;
+        pids[i].wait = 0;
+        pids[i].response_time = sentinel;
+        pids[i].tau = 10;  // Same initial prediction main gives every SRT row
+    }
+    *pid_count = new_count;
+    return pids;
+}
 
-        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
-        while (fgets(buffer, sizeof(buffer), stdin)) {
-            // Parse input and populate the process array
-            if (sscanf(buffer, "%d,%d,%d,%d", 
-                    &processes[n].process_id, 
-                    &processes[n].arrival_time, 
-                    &processes[n].time_until_first_response, 
-                    &processes[n].burst_time) == 4) {
-                n++;  // Increment process count
-            }
-        }
+// Function to fold one finished row into its pid's table entry, the same way
+// the display functions combine rows that share a pid
+void add_to_pid_summary(Pid_Summary *summary, const Process_For_Sim *row, int sentinel) {
+    if (summary->arrival == -1 || row->arrival_time < summary->arrival) summary->arrival = row->arrival_time;
+    if (summary->start == -1 || row->start_time < summary->start) summary->start = row->start_time;
+    if (summary->finish == -1 || row->completion_time > summary->finish) summary->finish = row->completion_time;
+    if (summary->response_time == sentinel || row->response_time < summary->response_time) summary->response_time = row->response_time;
+    summary->burst += row->burst_time;
+    summary->wait += row->waiting_time;
+}
 
-        // Sort the processes by arrival time
-        sort_same_arrival_time_processes_fcfs(processes, n);
+// Function to compute the average wait, turnaround and response times the table shows
+// for pids 1..last_pid, n being the total row count
+void average_pid_summaries(const Pid_Summary pids[], int pid_count, int last_pid, int n, int sentinel,
+                           double averages[3]) {
+    long long total_wait_time = 0, total_turnaround_time = 0, total_response_time = 0;  // Totals for averages
+
+    for (int i = 1; i <= last_pid; i++) {
+        Pid_Summary empty = {-1, 0, -1, -1, 0, sentinel, 10};
+        const Pid_Summary *summary = (i < pid_count) ? &pids[i] : &empty;
+        total_wait_time += summary->wait;
+        total_turnaround_time += summary->finish - summary->arrival;
+        total_response_time += summary->response_time - summary->arrival;
+    }
+    averages[0] = (float)total_wait_time / n;
+    averages[1] = (float)total_turnaround_time / n;
+    averages[2] = (float)total_response_time / n;
+}
 
-        // Simulate the FCFS algorithm
-        simulate_fcfs(processes, n);
-    } 
-    
-    // If the scheduling algorithm is SJF (Shortest Job First)
-    else if (strcmp(argv[1], "SJF") == 0) {
-        Process_For_SJF processes[MAX_PROCESSES];  // Array to store processes
-        int n = 0;  // Number of processes
-        
-        char buffer[BUFFER_SIZE];  // Buffer to read input
-        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
-        
-        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
-        while (fgets(buffer, sizeof(buffer), stdin)) {
-            // Parse input and populate the process array
-            if (sscanf(buffer, "%d,%d,%d,%d", 
-                    &processes[n].process_id, 
-                    &processes[n].arrival_time, 
-                    &processes[n].time_until_first_response, 
-                    &processes[n].burst_time) == 4) {
-                processes[n].finished = false;  // Initialize process as not finished
-                n++;  // Increment process count
-            }
-        }
-        
-        // Sort processes by arrival time
-        sort_same_arrival_time_processes_sjf(processes, n);
+// Functions for the structured result formats
+//
+// --format csv|jsonl|bin writes the per-pid results for programs instead of the
+// table. Only pids that had rows are written. The averages are the table's,
+// followed by the --stats figures, in a summary at the end. Everything goes
+// through a 1 MiB buffer and integers are formatted by hand: one printf per pid
+// made ten million rows take tens of seconds. --quiet writes only the summary.
+// EDF and EDF-NP add the deadline figures after the summary.
+//
+//     csv    pid,arrival,burst,start,finish,wait,turnaround,response lines, an
+//            empty line, then a header line and one line for the summary; for
+//            EDF another empty line, header line and line for the deadlines
+//     jsonl  one object per pid, then one object for the summary and for EDF
+//            one for the deadlines
+//     bin    RESULT_MAGIC, an int32 record count, that many Result_Records,
+//            one Result_Summary and for EDF one Result_Deadlines, all
+//            native-endian
+
+#define RESULT_MAGIC "SCHEDRT1"
+#define RESULT_BUFFER_SIZE (1 << 20)
+
+// One pid as written by the binary format
+typedef struct {
+    int32_t pid;
+    int32_t arrival;
+    int32_t burst;
+    int32_t start;
+    int32_t finish;
+    int32_t wait;
+    int32_t turnaround;
+    int32_t response;
+} Result_Record;
+
+// The summary written by the binary format
+typedef struct {
+    double average_waiting;
+    double average_turnaround;
+    double average_response;
+    int64_t context_switches;
+    int64_t cache_refills;
+    int64_t switch_overhead;
+    int64_t idle_time;
+    double cpu_utilization;     // Percent
+    double throughput;          // Jobs per ms
+} Result_Summary;
+
+// The deadline figures written after the summary for EDF (all zero if no row has a deadline)
+typedef struct {
+    int64_t deadlines;          // Rows with a deadline
+    int64_t misses;             // Rows that finished after their deadline
+    int64_t lateness_min;
+    double lateness_mean;
+    int64_t lateness_p50;
+    int64_t lateness_p90;
+    int64_t lateness_p99;
+    int64_t lateness_max;
+} Result_Deadlines;
 
-        // Simulate the Shortest Job Next (SPN) algorithm (non-preemptive SJF)
-        simulateSPN(processes, n);
+typedef struct {
+    size_t used;
+    char buffer[RESULT_BUFFER_SIZE];
+} Result_Writer;
 
-        // Display results and calculate average wait, turnaround, and response times
-        display_and_calculate_averages_sjf(processes, n);
+Result_Writer results;
+
+// Function to write out the result buffer to stdout
+void results_flush(void) {
+    if (results.used > 0 && fwrite(results.buffer, 1, results.used, stdout) != results.used) {
+        fprintf(stderr, "Error: Could not write the results.\n");
+        exit(1);
     }
-    
-    // If the scheduling algorithm is Priority
-    else if (strcmp(argv[1], "Priority") == 0) {
-        Process_For_Priority processes[MAX_PROCESSES];  // Array to store processes
-        int n = 0;  // Number of processes
-        char buffer[BUFFER_SIZE];  // Buffer to read input
-        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
+    results.used = 0;
+}
 
-        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
-        while (fgets(buffer, sizeof(buffer), stdin)) {
-            // Parse input and populate the process array
-            if (sscanf(buffer, "%d,%d,%d,%d", 
-                    &processes[n].process_id, 
-                    &processes[n].arrival_time, 
-                    &processes[n].time_until_first_response, 
-                    &processes[n].burst_time) == 4) {
-                // Calculate priority as 1 / Process ID (lower process ID = higher priority)
-                processes[n].priority = (float) 1.0 / (processes[n].process_id);  
-                processes[n].start_time = -1;  // Start time is initially -1 (hasn't started yet)
-                processes[n].completed = false;  // Mark process as not completed
-                n++;  // Increment process count
-            }
-        }
+// Function to append bytes to the result buffer, flushing it when full
+void results_write(const void *data, size_t length) {
+    if (results.used + length > RESULT_BUFFER_SIZE) {
+        results_flush();
+    }
+    memcpy(results.buffer + results.used, data, length);
+    results.used += length;
+}
 
-        // Sort processes by arrival time
-        sort_same_arrival_time_processes_priority(processes, n);
+// Function to return where up to length bytes can be formatted straight into the
+// result buffer; the caller moves results.used past what it wrote
+char *results_reserve(size_t length) {
+    if (results.used + length > RESULT_BUFFER_SIZE) {
+        results_flush();
+    }
+    return results.buffer + results.used;
+}
 
-        // Simulate the Priority scheduling algorithm
-        calculate_times(processes, n);
+// Function to write one pid in the chosen format
+void write_result_record(const Result_Record *record) {
+    if (options.output == OUTPUT_BINARY) {
+        results_write(record, sizeof(*record));
+        return;
+    }
+    const int32_t *values = &record->pid;
+    char *line = results_reserve(256);
+    char *end = line;
+    if (options.output == OUTPUT_JSONL) {
+        // Copied 16 bytes at a time, which the reserved space allows for
+        static const char keys[8][16] = {"{\"pid\":", ",\"arrival\":", ",\"burst\":", ",\"start\":",
+                                         ",\"finish\":", ",\"wait\":", ",\"turnaround\":", ",\"response\":"};
+        static const unsigned char key_lengths[8] = {7, 11, 9, 9, 10, 8, 14, 12};
+        for (int i = 0; i < 8; i++) {
+            memcpy(end, keys[i], 16);
+            end = format_decimal(end + key_lengths[i], values[i]);
+        }
+        *end++ = '}';
+    } else {
+        for (int i = 0; i < 8; i++) {
+            end = format_decimal(end, values[i]);
+            *end++ = ',';
+        }
+        end--;  // No comma after the last value
+    }
+    *end++ = '\n';
+    results.used += end - line;
+}
 
-        // Display results and calculate average wait, turnaround, and response times
-        display_and_calculate_averages_priority(processes, n);
+// Function to write the summary in the chosen format
+void write_result_summary(const Result_Summary *summary) {
+    if (options.output == OUTPUT_BINARY) {
+        results_write(summary, sizeof(*summary));
+        return;
     }
-    
-    // If the scheduling algorithm is Round Robin (RR)
+    char text[512];
+    int length;
+    if (options.output == OUTPUT_JSONL) {
+        length = snprintf(text, sizeof(text),
+                          "{\"average_waiting\":%.2f,\"average_turnaround\":%.2f,\"average_response\":%.2f,"
+                          "\"context_switches\":%lld,\"cache_refills\":%lld,\"switch_overhead\":%lld,"
+                          "\"idle_time\":%lld,\"cpu_utilization\":%.2f,\"throughput\":%.4f}\n",
+                          summary->average_waiting, summary->average_turnaround, summary->average_response,
+                          (long long)summary->context_switches, (long long)summary->cache_refills,
+                          (long long)summary->switch_overhead, (long long)summary->idle_time,
+                          summary->cpu_utilization, summary->throughput);
+    } else {
+        length = snprintf(text, sizeof(text),
+                          "average_waiting,average_turnaround,average_response,context_switches,cache_refills,"
+                          "switch_overhead,idle_time,cpu_utilization,throughput\n"
+                          "%.2f,%.2f,%.2f,%lld,%lld,%lld,%lld,%.2f,%.4f\n",
+                          summary->average_waiting, summary->average_turnaround, summary->average_response,
+                          (long long)summary->context_switches, (long long)summary->cache_refills,
+                          (long long)summary->switch_overhead, (long long)summary->idle_time,
+                          summary->cpu_utilization, summary->throughput);
+    }
+    results_write(text, (size_t)length);
+}
+
+// Function to write the deadline figures in the chosen format
+void write_result_deadlines(const Result_Deadlines *deadlines) {
+    if (options.output == OUTPUT_BINARY) {
+        results_write(deadlines, sizeof(*deadlines));
+        results_flush();
+        return;
+    }
+    char text[512];
+    int length;
+    if (options.output == OUTPUT_JSONL) {
+        length = snprintf(text, sizeof(text),
+                          "{\"deadlines\":%lld,\"misses\":%lld,\"lateness_min\":%lld,\"lateness_mean\":%.2f,"
+                          "\"lateness_p50\":%lld,\"lateness_p90\":%lld,\"lateness_p99\":%lld,\"lateness_max\":%lld}\n",
+                          (long long)deadlines->deadlines, (long long)deadlines->misses,
+                          (long long)deadlines->lateness_min, deadlines->lateness_mean,
+                          (long long)deadlines->lateness_p50, (long long)deadlines->lateness_p90,
+                          (long long)deadlines->lateness_p99, (long long)deadlines->lateness_max);
+    } else {
+        length = snprintf(text, sizeof(text),
+                          "\ndeadlines,misses,lateness_min,lateness_mean,lateness_p50,lateness_p90,lateness_p99,lateness_max\n"
+                          "%lld,%lld,%lld,%.2f,%lld,%lld,%lld,%lld\n",
+                          (long long)deadlines->deadlines, (long long)deadlines->misses,
+                          (long long)deadlines->lateness_min, deadlines->lateness_mean,
+                          (long long)deadlines->lateness_p50, (long long)deadlines->lateness_p90,
+                          (long long)deadlines->lateness_p99, (long long)deadlines->lateness_max);
+    }
+    results_write(text, (size_t)length);
+    results_flush();
+}
+
+// Function to write per-pid summaries for pids 1..last_pid in a structured format,
+// n being the total row count
+void write_pid_summaries(const Pid_Summary pids[], int pid_count, int last_pid, int n, int sentinel) {
+    int limit = options.quiet ? 0 : (last_pid < pid_count - 1) ? last_pid : pid_count - 1;  // Beyond pid_count no rows
+    if (options.output == OUTPUT_BINARY) {
+        int32_t count = 0;
+        for (int i = 1; i <= limit; i++) {
+            if (pids[i].arrival != -1) count++;
+        }
+        results_write(RESULT_MAGIC, strlen(RESULT_MAGIC));
+        results_write(&count, sizeof(count));
+    }
+    if (!options.quiet) {
+        const char *header = "pid,arrival,burst,start,finish,wait,turnaround,response\n";
+        if (options.output == OUTPUT_CSV) {
+            results_write(header, strlen(header));
+        }
+        for (int i = 1; i <= limit; i++) {
+            const Pid_Summary *summary = &pids[i];
+            if (summary->arrival == -1) {
+                continue;
+            }
+            Result_Record record = {i, summary->arrival, summary->burst, summary->start, summary->finish, summary->wait,
+                                    summary->finish - summary->arrival, summary->response_time - summary->arrival};
+            write_result_record(&record);
+        }
+        if (options.output == OUTPUT_CSV) {
+            results_write("\n", 1);
+        }
+    }
+
+    // The averages as the table shows them and the figures --stats prints
+    double averages[3];
+    average_pid_summaries(pids, pid_count, last_pid, n, sentinel, averages);
+    long long span = (cpu_stats.jobs > 0) ? (long long)cpu_stats.last_finish - cpu_stats.first_arrival : 0;
+    long long capacity = cpu_capacity();
+    Result_Summary summary = {averages[0], averages[1], averages[2], cpu_stats.switches, cpu_stats.refills,
+                              cpu_stats.overhead, capacity - cpu_stats.busy - cpu_stats.overhead,
+                              (span > 0) ? 100.0 * cpu_stats.busy / capacity : 0,
+                              (span > 0) ? (double)cpu_stats.jobs / span : 0};
+    write_result_summary(&summary);
+    results_flush();
+}
+
+// Function to print the results table from per-pid summaries for pids 1..last_pid,
+// n being the total row count
+void display_pid_summaries(Pid_Summary pids[], int pid_count, int last_pid, int n, int sentinel) {
+    if (options.output != OUTPUT_TABLE) {
+        write_pid_summaries(pids, pid_count, last_pid, n, sentinel);
+        return;
+    }
+    if (!options.quiet) {
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+        printf("| Id | Arrival | Burst | Start | Finish |    Wait |   Turnaround   | Response Time |\n");
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+
+        for (int i = 1; i <= last_pid; i++) {
+            Pid_Summary empty = {-1, 0, -1, -1, 0, sentinel, 10};
+            Pid_Summary *summary = (i < pid_count) ? &pids[i] : &empty;
+
+            // Calculate turnaround and response times
+            int turnaround = summary->finish - summary->arrival;
+            int response_time = summary->response_time - summary->arrival;
+
+            printf("| %-2d | %-7d | %-5d | %-5d | %-6d | %-7d | %-14d | %-13d |\n", i, summary->arrival, summary->burst,
+                   summary->start, summary->finish, summary->wait, turnaround, response_time);
+        }
+
+        printf("+----+---------+-------+-------+--------+---------+----------------+---------------+\n");
+    }
+
+    // Print average times
+    double averages[3];
+    average_pid_summaries(pids, pid_count, last_pid, n, sentinel, averages);
+    printf(options.quiet ? "Average Waiting Time: %.2f ms\n" : "\nAverage Waiting Time: %.2f ms\n", averages[0]);
+    printf("Average Turnaround Time: %.2f ms\n", averages[1]);
+    printf("Average Response Time: %.2f ms\n", averages[2]);
+}
+
+// Function to load a state file; returns false if it is missing or was built with other settings
+bool load_incremental_state(const char *path, const char *algorithm, float parameter, Incremental_State *state) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return false;
+    }
+
+    Incremental_Header *header = &state->header;
+    bool ok = fread(header, sizeof(*header), 1, file) == 1 &&
+              memcmp(header->magic, INCREMENTAL_MAGIC, 8) == 0 &&
+              header->version == INCREMENTAL_VERSION &&
+              strncmp(header->algorithm, algorithm, sizeof(header->algorithm)) == 0 &&
+              header->parameter == parameter &&
+              header->sequence_length >= 0 && header->pid_count >= 0 &&
+              header->check_length > 0 && header->check_length <= BUFFER_SIZE;
+
+    state->sequence = NULL;
+    state->pids = NULL;
+    if (ok) {
+        state->sequence = (int *)malloc((header->sequence_length + 1) * sizeof(int));
+        state->pids = (Pid_Summary *)malloc((header->pid_count + 1) * sizeof(Pid_Summary));
+        if (state->sequence == NULL || state->pids == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        ok = fread(state->sequence, sizeof(int), header->sequence_length, file) == (size_t)header->sequence_length &&
+             fread(state->pids, sizeof(Pid_Summary), header->pid_count, file) == (size_t)header->pid_count;
+    }
+    fclose(file);
+
+    if (!ok) {
+        free(state->sequence);
+        free(state->pids);
+    }
+    return ok;
+}
+
+// Function to write a state file (via a temporary file, so a crash keeps the old one)
+void save_incremental_state(const char *path, const Incremental_State *state) {
+    char temp_path[BUFFER_SIZE];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+
+    FILE *file = fopen(temp_path, "wb");
+    if (file == NULL) {
+        printf("Error: cannot write incremental state '%s'.\n", temp_path);
+        exit(1);
+    }
+    const Incremental_Header *header = &state->header;
+    bool ok = fwrite(header, sizeof(*header), 1, file) == 1 &&
+              fwrite(state->sequence, sizeof(int), header->sequence_length, file) == (size_t)header->sequence_length &&
+              fwrite(state->pids, sizeof(Pid_Summary), header->pid_count, file) == (size_t)header->pid_count;
+    if (fclose(file) != 0 || !ok || rename(temp_path, path) != 0) {
+        printf("Error: cannot write incremental state '%s'.\n", path);
+        exit(1);
+    }
+}
+
+// Function to position the trace just after the saved quiescent point. The line
+// ending there is read back and compared, so a replaced trace is not resumed.
+bool seek_to_quiescent_point(FILE *input, const Incremental_Header *header) {
+    long long skip = header->input_offset - header->check_length;
+    if (skip < 0) {
+        return false;
+    }
+
+    if (fseeko(input, (off_t)skip, SEEK_SET) != 0) {
+        // Not seekable (a pipe): read past the part already simulated
+        char chunk[BUFFER_SIZE];
+        while (skip > 0) {
+            size_t want = (skip < (long long)sizeof(chunk)) ? (size_t)skip : sizeof(chunk);
+            size_t got = fread(chunk, 1, want, input);
+            if (got == 0) {
+                return false;
+            }
+            skip -= got;
+        }
+    }
+
+    char line[BUFFER_SIZE];
+    if (fread(line, 1, header->check_length, input) != (size_t)header->check_length) {
+        return false;
+    }
+    return hash_bytes(line, header->check_length, HASH_SEED) == header->check_hash;
+}
+
+// Function to parse "pid,arrival,ttfr,burst[,optional]" into a zeroed row; false if
+// the line has fewer than four numbers. Accepts what sscanf("%d,%d,%d,%d,%d") does,
+// without its cost per call
+bool parse_sim_row(const char *line, Process_For_Sim *row) {
+    int values[5];
+    int fields = 0;
+    const char *cursor = line;
+    while (fields < 5) {
+        char *end;
+        long value = strtol(cursor, &end, 10);
+        if (end == cursor) {
+            break;
+        }
+        values[fields++] = (int)value;
+        if (*end != ',') {
+            break;
+        }
+        cursor = end + 1;
+    }
+    if (fields < 4) {
+        return false;
+    }
+    memset(row, 0, sizeof(*row));
+    row->process_id = values[0];
+    row->arrival_time = values[1];
+    row->time_until_first_response = values[2];
+    row->burst_time = values[3];
+    row->has_optional_column = (fields == 5);
+    row->optional_column = (fields == 5) ? values[4] : 0;
+    return true;
+}
+
+// Function to read the remaining rows of a trace, position being the offset already consumed
+Process_For_Sim *read_sim_rows(FILE *input, long long position, int *count) {
+    int capacity = 1024, n = 0;
+    Process_For_Sim *rows = (Process_For_Sim *)malloc(capacity * sizeof(Process_For_Sim));
+    char buffer[BUFFER_SIZE];
+    if (rows == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
+    // and an optional fifth column that some schedulers use
+    while (fgets(buffer, sizeof(buffer), input)) {
+        int length = (int)strlen(buffer);
+        position += length;
+
+        Process_For_Sim row;
+        if (!parse_sim_row(buffer, &row)) {
+            continue;
+        }
+        row.input_index = n;
+        row.input_end = position;
+        row.line_length = length;
+        row.line_hash = hash_bytes(buffer, length, HASH_SEED);
+
+        if (n == capacity) {
+            capacity *= 2;
+            rows = (Process_For_Sim *)realloc(rows, capacity * sizeof(Process_For_Sim));
+            if (rows == NULL) {
+                printf("Memory allocation failed\n");
+                exit(1);
+            }
+        }
+        rows[n++] = row;
+    }
+
+    *count = n;
+    return rows;
+}
+
+// Function to order rows the way the sort_same_arrival_time_processes_* functions do
+int compare_sim_rows(const void *a, const void *b) {
+    const Process_For_Sim *x = (const Process_For_Sim *)a;
+    const Process_For_Sim *y = (const Process_For_Sim *)b;
+    if (x->arrival_time != y->arrival_time) return (x->arrival_time < y->arrival_time) ? -1 : 1;
+    if (x->process_id != y->process_id) return (x->process_id < y->process_id) ? -1 : 1;
+    return x->input_index - y->input_index;  // Bubble sort is stable, keep input order
+}
+
+// Pair used to sort finished rows into completion order
+typedef struct {
+    int completion_time;
+    int index;
+} Completion_Entry;
+
+int compare_completions(const void *a, const void *b) {
+    const Completion_Entry *x = (const Completion_Entry *)a;
+    const Completion_Entry *y = (const Completion_Entry *)b;
+    if (x->completion_time != y->completion_time) return (x->completion_time < y->completion_time) ? -1 : 1;
+    return x->index - y->index;
+}
+
+// Function to run one of the existing simulators over sorted rows whose arrival
+// times have had shift taken off, and copy the results back in absolute time
+void simulate_sim_rows(const char *algorithm, float parameter, Process_For_Sim rows[], int n, int shift,
+                       const Pid_Summary pids[], int pid_count) {
+    if (n == 0) {
+        return;
+    }
+
+    // The rows are already in arrival order, so the O(n^2) sorts are skipped
+    if (strcmp(algorithm, "FCFS") == 0) {
+        Process_For_FCFS *processes = (Process_For_FCFS *)calloc(n, sizeof(Process_For_FCFS));
+        if (processes == NULL) { printf("Memory allocation failed\n"); exit(1); }
+        for (int i = 0; i < n; i++) {
+            processes[i].process_id = rows[i].process_id;
+            processes[i].arrival_time = rows[i].arrival_time - shift;
+            processes[i].time_until_first_response = rows[i].time_until_first_response;
+            processes[i].burst_time = rows[i].burst_time;
+        }
+        simulate_fcfs(processes, n);
+        for (int i = 0; i < n; i++) {
+            rows[i].start_time = processes[i].start_time + shift;
+            rows[i].completion_time = processes[i].finish_time + shift;
+            rows[i].waiting_time = processes[i].wait_time;
+            rows[i].response_time = processes[i].response_time + shift;  // Includes the arrival time
+        }
+        free(processes);
+    } else if (strcmp(algorithm, "SJF") == 0) {
+        Process_For_SJF *processes = (Process_For_SJF *)calloc(n, sizeof(Process_For_SJF));
+        if (processes == NULL) { printf("Memory allocation failed\n"); exit(1); }
+        for (int i = 0; i < n; i++) {
+            processes[i].process_id = rows[i].process_id;
+            processes[i].arrival_time = rows[i].arrival_time - shift;
+            processes[i].time_until_first_response = rows[i].time_until_first_response;
+            processes[i].burst_time = rows[i].burst_time;
+            processes[i].finished = false;
+        }
+        simulateSPN(processes, n);
+        for (int i = 0; i < n; i++) {
+            rows[i].start_time = processes[i].start_time + shift;
+            rows[i].completion_time = processes[i].completion_time + shift;
+            rows[i].waiting_time = processes[i].waiting_time;
+            rows[i].response_time = processes[i].response_time + shift;  // Includes the arrival time
+        }
+        free(processes);
+    } else if (strcmp(algorithm, "Priority") == 0) {
+        Process_For_Priority *processes = (Process_For_Priority *)calloc(n, sizeof(Process_For_Priority));
+        if (processes == NULL) { printf("Memory allocation failed\n"); exit(1); }
+        for (int i = 0; i < n; i++) {
+            processes[i].process_id = rows[i].process_id;
+            processes[i].arrival_time = rows[i].arrival_time - shift;
+            processes[i].time_until_first_response = rows[i].time_until_first_response;
+            processes[i].burst_time = rows[i].burst_time;
+            processes[i].priority = (float) 1.0 / (processes[i].process_id);
+            processes[i].start_time = -1;
+            processes[i].completed = false;
+        }
+        calculate_times(processes, n);
+        for (int i = 0; i < n; i++) {
+            rows[i].start_time = processes[i].start_time + shift;
+            rows[i].completion_time = processes[i].completion_time + shift;
+            rows[i].waiting_time = processes[i].waiting_time;
+            rows[i].response_time = processes[i].response_time;  // Relative to arrival already
+        }
+        free(processes);
+    } else if (strcmp(algorithm, "RR") == 0) {
+        Process_For_RR *processes = (Process_For_RR *)calloc(n, sizeof(Process_For_RR));
+        if (processes == NULL) { printf("Memory allocation failed\n"); exit(1); }
+        for (int i = 0; i < n; i++) {
+            processes[i].process_id = rows[i].process_id;
+            processes[i].arrival_time = rows[i].arrival_time - shift;
+            processes[i].time_until_first_response = rows[i].time_until_first_response;
+            processes[i].burst_time = rows[i].burst_time;
+            processes[i].remaining_time = processes[i].burst_time;
+            processes[i].first_response = false;
+            processes[i].start_time = -1;
+            processes[i].response_time = -1;  // Stays -1 if the response point is never reached
+        }
+        simulateRR(processes, n, (int)parameter);
+        for (int i = 0; i < n; i++) {
+            rows[i].start_time = processes[i].start_time + shift;
+            rows[i].completion_time = processes[i].completion_time + shift;
+            rows[i].waiting_time = processes[i].waiting_time;
+            rows[i].response_time = (processes[i].response_time == -1) ? -1 : processes[i].response_time + shift;
+        }
+        free(processes);
+    } else {
+        Process_For_SRT *processes = (Process_For_SRT *)calloc(n, sizeof(Process_For_SRT));
+        if (processes == NULL) { printf("Memory allocation failed\n"); exit(1); }
+        for (int i = 0; i < n; i++) {
+            int pid = rows[i].process_id;
+            processes[i].process_id = pid;
+            processes[i].arrival_time = rows[i].arrival_time - shift;
+            processes[i].time_until_first_response = rows[i].time_until_first_response;
+            processes[i].actual_cpu_burst = rows[i].burst_time;
+            processes[i].remaining_time = processes[i].actual_cpu_burst;
+            processes[i].start_time = -1;
+            // Carry the prediction over from the rows already folded into the state
+            processes[i].predicted_cpu_burst = (pid >= 0 && pid < pid_count) ? pids[pid].tau : 10;
+            processes[i].predicted_remaining_time = processes[i].predicted_cpu_burst;
+            processes[i].completed = false;
+        }
+        simulate_preemptive_srt(processes, n, parameter);
+        for (int i = 0; i < n; i++) {
+            rows[i].start_time = processes[i].start_time + shift;
+            rows[i].completion_time = processes[i].finish_time + shift;
+            rows[i].waiting_time = processes[i].waiting_time;
+            rows[i].response_time = processes[i].response_time;  // Relative to arrival already
+        }
+        free(processes);
+    }
+}
+
+// Function to simulate only the part of the trace after the saved quiescent
+// point, print the results for the whole trace and move the quiescent point on
+int run_incremental(const char *algorithm, const char *parameter_text) {
+    int sentinel = response_sentinel(algorithm);
+    if (sentinel == -2) {
+        printf("Error: Unsupported scheduling algorithm '%s'.\n", algorithm);
+        return 1;
+    }
+    bool needs_parameter = strcmp(algorithm, "RR") == 0 || strcmp(algorithm, "SRT") == 0;
+    if (needs_parameter != (parameter_text != NULL)) {
+        printf("Error: No scheduling algorithm specified.\n");
+        return 1;
+    }
+    float parameter = 0;
+    if (parameter_text != NULL) {
+        parameter = (strcmp(algorithm, "RR") == 0) ? (float)atoi(parameter_text) : (float)atof(parameter_text);
+    }
+
+    if (strcmp(algorithm, "SRT") == 0 && options.predictor != PREDICTOR_EXPONENTIAL) {
+        printf("Error: --incremental only keeps the exponential SRT predictor between runs.\n");
+        return 1;
+    }
+
+    const char *path = options.incremental_state;
+    Incremental_State state;
+    Process_For_Sim *rows = NULL;
+    int n = 0;
+
+    bool resumed = load_incremental_state(path, algorithm, parameter, &state);
+    if (resumed) {
+        resumed = seek_to_quiescent_point(stdin, &state.header);
+        if (resumed) {
+            rows = read_sim_rows(stdin, state.header.input_offset, &n);
+            // A row before the quiescent point means the trace was not just appended to
+            for (int i = 0; i < n && resumed; i++) {
+                resumed = rows[i].arrival_time >= state.header.quiescent_time;
+            }
+        }
+        if (!resumed) {
+            free(rows);
+            free(state.sequence);
+            free(state.pids);
+            if (fseeko(stdin, 0, SEEK_SET) != 0) {
+                printf("Error: incremental state '%s' does not match the trace and the input can not be rewound.\n", path);
+                return 1;
+            }
+        }
+    }
+
+    if (!resumed) {
+        // Start from an empty state at the beginning of the trace
+        memset(&state, 0, sizeof(state));
+        memcpy(state.header.magic, INCREMENTAL_MAGIC, 8);
+        state.header.version = INCREMENTAL_VERSION;
+        strncpy(state.header.algorithm, algorithm, sizeof(state.header.algorithm) - 1);
+        state.header.parameter = parameter;
+
+        char buffer[BUFFER_SIZE];
+        long long position = 0;
+        if (fgets(buffer, sizeof(buffer), stdin)) {  // Skip the first line (header)
+            position = (long long)strlen(buffer);
+        }
+        rows = read_sim_rows(stdin, position, &n);
+    }
+
+    Incremental_Header *header = &state.header;
+
+    // Simulate the new rows alone, shifted to start at the quiescent point
+    qsort(rows, n, sizeof(Process_For_Sim), compare_sim_rows);
+    bool show_sequence = sequence_output_enabled;
+    sequence_output_enabled = false;
+    simulate_sim_rows(algorithm, parameter, rows, n, header->quiescent_time, state.pids, header->pid_count);
+    sequence_output_enabled = show_sequence;
+
+    // Completion order of the new rows
+    Completion_Entry *order = (Completion_Entry *)malloc((n + 1) * sizeof(Completion_Entry));
+    if (order == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        order[i].completion_time = rows[i].completion_time;
+        order[i].index = i;
+    }
+    qsort(order, n, sizeof(Completion_Entry), compare_completions);
+
+    // Print the sequence for the whole trace
+    if (show_sequence) {
+        printf("seq = [");
+        for (int i = 0; i < header->sequence_length; i++) {
+            printf(i == 0 ? "%d" : ",%d", state.sequence[i]);
+        }
+        for (int i = 0; i < n; i++) {
+            printf((header->sequence_length + i) == 0 ? "%d" : ",%d", rows[order[i].index].process_id);
+        }
+        printf("]\n");
+    }
+
+    // Find the new quiescent point: the longest run of rows that is both a prefix
+    // of the input and of the arrival order, and finishes before the next row
+    // arrives. The end of the trace does not count, rows appended later may
+    // still arrive while the last ones run.
+    int cut = 0, cut_finish = 0, max_index = -1, max_finish = 0;
+    for (int k = 1; k < n; k++) {
+        if (rows[k - 1].input_index > max_index) max_index = rows[k - 1].input_index;
+        if (rows[k - 1].completion_time > max_finish) max_finish = rows[k - 1].completion_time;
+        if (max_index == k - 1 && max_finish <= rows[k].arrival_time) {
+            cut = k;
+            cut_finish = max_finish;
+        }
+    }
+
+    // Fold the rows before it into the saved table
+    for (int i = 0; i < cut; i++) {
+        if (rows[i].process_id >= 0) {
+            state.pids = grow_pid_summaries(state.pids, &header->pid_count, rows[i].process_id, sentinel);
+            add_to_pid_summary(&state.pids[rows[i].process_id], &rows[i], sentinel);
+        }
+    }
+
+    // Print the table for the whole trace, adding the rows after the quiescent point on a copy
+    int display_count = header->pid_count;
+    Pid_Summary *display = (Pid_Summary *)malloc((display_count + 1) * sizeof(Pid_Summary));
+    if (display == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(display, state.pids, display_count * sizeof(Pid_Summary));
+    for (int i = cut; i < n; i++) {
+        if (rows[i].process_id >= 0) {
+            display = grow_pid_summaries(display, &display_count, rows[i].process_id, sentinel);
+            add_to_pid_summary(&display[rows[i].process_id], &rows[i], sentinel);
+        }
+    }
+    display_pid_summaries(display, display_count, 50, header->rows + n, sentinel);
+    free(display);
+
+    if (cut > 0) {
+        // Append the finished rows to the saved sequence, replaying the SRT predictions
+        state.sequence = (int *)realloc(state.sequence, (header->sequence_length + cut + 1) * sizeof(int));
+        if (state.sequence == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        for (int i = 0; i < n; i++) {
+            Process_For_Sim *row = &rows[order[i].index];
+            if (order[i].index >= cut) {
+                continue;
+            }
+            state.sequence[header->sequence_length++] = row->process_id;
+            if (strcmp(algorithm, "SRT") == 0 && row->process_id >= 0) {
+                Pid_Summary *summary = &state.pids[row->process_id];
+                summary->tau = (parameter * row->burst_time) + ((1 - parameter) * summary->tau);
+            }
+        }
+
+        // The last row of the input before the quiescent point marks where the next run resumes
+        for (int i = 0; i < cut; i++) {
+            if (rows[i].input_index == cut - 1) {
+                header->input_offset = rows[i].input_end;
+                header->check_length = rows[i].line_length;
+                header->check_hash = rows[i].line_hash;
+            }
+        }
+        header->quiescent_time = cut_finish;
+        header->rows += cut;
+        save_incremental_state(path, &state);
+    }
+
+    free(order);
+    free(rows);
+    free(state.sequence);
+    free(state.pids);
+    return 0;
+}
+
+// Functions shared by the event-driven schedulers
+//
+// These work on Process_For_Sim rows and jump straight from one event
+// (arrival, completion, quantum expiry) to the next instead of ticking.
+// Response time follows simulateRR: the time at which the process has run
+// for time_until_first_response units, or -1 if it never gets that far.
+
+// Function to sort rows by arrival and reset what the simulators fill in
+void prepare_sim_rows(Process_For_Sim rows[], int n) {
+    qsort(rows, n, sizeof(Process_For_Sim), compare_sim_rows);
+    for (int i = 0; i < n; i++) {
+        rows[i].remaining_time = rows[i].burst_time;
+        rows[i].start_time = -1;
+        rows[i].completion_time = -1;
+        rows[i].response_time = -1;
+    }
+}
+
+// Function to read a trace from stdin (header line first) and sort it by arrival
+Process_For_Sim *read_trace_from_stdin(int *count) {
+    char buffer[BUFFER_SIZE];
+    long long position = 0;
+    if (fgets(buffer, sizeof(buffer), stdin)) {  // Skip the first line (header)
+        position = (long long)strlen(buffer);
+    }
+
+    Process_For_Sim *rows = read_sim_rows(stdin, position, count);
+    prepare_sim_rows(rows, *count);
+    return rows;
+}
+
+// Function to account for a process running on core from start for slice time units
+void run_sim_slice_on(Process_For_Sim *row, int start, int slice, int core) {
+    int executed = row->burst_time - row->remaining_time;
+    if (row->start_time == -1) {
+        row->start_time = start;
+    }
+    // The response point falls inside this slice
+    if (row->time_until_first_response > executed && row->time_until_first_response <= executed + slice) {
+        row->response_time = start + (row->time_until_first_response - executed);
+    }
+    row->remaining_time -= slice;
+    timeline_slice(row->process_id, start, start + slice, core);
+}
+
+// Function to account for a process running from start for slice time units
+void run_sim_slice(Process_For_Sim *row, int start, int slice) {
+    run_sim_slice_on(row, start, slice, 0);
+}
+
+// Function to record a process finishing at time
+void finish_sim_row(Process_For_Sim *row, int time) {
+    row->completion_time = time;
+    row->waiting_time = (row->completion_time - row->arrival_time) - row->burst_time;
+    record_completion(row->arrival_time, row->burst_time, time);
+}
+
+// Function to print a completion sequence held as an array of process IDs
+void emit_sequence_ids(const int ids[], int count) {
+    if (!sequence_output_enabled) {
+        return;
+    }
+    printf("seq = [");
+    for (int i = 0; i < count; i++) {
+        printf(i == 0 ? "%d" : ",%d", ids[i]);
+    }
+    printf("]\n");
+}
+
+// Function to fold rows into per-pid summaries; last_pid is the largest pid, at least 50
+Pid_Summary *summarize_sim_rows(const Process_For_Sim rows[], int n, int sentinel, int *pid_count, int *last_pid) {
+    Pid_Summary *pids = NULL;
+    *pid_count = 0;
+    *last_pid = 50;
+    for (int i = 0; i < n; i++) {
+        if (rows[i].process_id >= 0) {
+            pids = grow_pid_summaries(pids, pid_count, rows[i].process_id, sentinel);
+            add_to_pid_summary(&pids[rows[i].process_id], &rows[i], sentinel);
+            if (rows[i].process_id > *last_pid) *last_pid = rows[i].process_id;
+        }
+    }
+    return pids;
+}
+
+// Function to print the results table for rows, every pid up to the largest
+// (at least 50) and sentinel being the response-time sentinel of the algorithm
+void display_sim_rows(Process_For_Sim rows[], int n, int sentinel) {
+    int pid_count, last_pid;
+    Pid_Summary *pids = summarize_sim_rows(rows, n, sentinel, &pid_count, &last_pid);
+    display_pid_summaries(pids, pid_count, last_pid, n, sentinel);
+    free(pids);
+}
+
+// Function to compute the averages display_sim_rows would print
+void average_sim_rows(const Process_For_Sim rows[], int n, int sentinel, double averages[3]) {
+    int pid_count, last_pid;
+    Pid_Summary *pids = summarize_sim_rows(rows, n, sentinel, &pid_count, &last_pid);
+    average_pid_summaries(pids, pid_count, last_pid, n, sentinel, averages);
+    free(pids);
+}
+
+// Function to display processes and calculate average times for the event-driven schedulers,
+// in the same format as display_and_calculate_averages_RR
+void display_and_calculate_averages_sim(Process_For_Sim rows[], int n) {
+    display_sim_rows(rows, n, -1);
+}
+
+// Binary min-heap of process indexes, ordered by a key array (ties go to the lower index)
+typedef struct {
+    int *items;                   // Heap-ordered process indexes
+    int size;
+    const uint64_t *key;          // Key of each process
+} Index_Heap;
+
+bool heap_less(const Index_Heap *heap, int a, int b) {
+    return heap->key[a] < heap->key[b] || (heap->key[a] == heap->key[b] && a < b);
+}
+
+// Function to create an empty heap with room for capacity indexes
+Index_Heap heap_create(int capacity, const uint64_t *key) {
+    Index_Heap heap;
+    heap.items = (int *)malloc((capacity + 1) * sizeof(int));
+    if (heap.items == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    heap.size = 0;
+    heap.key = key;
+    return heap;
+}
+
+void heap_push(Index_Heap *heap, int index) {
+    int child = heap->size++;
+    while (child > 0) {
+        int parent = (child - 1) / 2;
+        if (!heap_less(heap, index, heap->items[parent])) break;
+        heap->items[child] = heap->items[parent];
+        child = parent;
+    }
+    heap->items[child] = index;
+}
+
+int heap_pop(Index_Heap *heap) {
+    int top = heap->items[0];
+    int last = heap->items[--heap->size];
+    int parent = 0;
+    while (true) {
+        int child = 2 * parent + 1;
+        if (child >= heap->size) break;
+        if (child + 1 < heap->size && heap_less(heap, heap->items[child + 1], heap->items[child])) child++;
+        if (!heap_less(heap, heap->items[child], last)) break;
+        heap->items[parent] = heap->items[child];
+        parent = child;
+    }
+    if (heap->size > 0) heap->items[parent] = last;
+    return top;
+}
+
+// Two-level bitmap over 0..size-1 with find-next-set; summary has a bit per non-zero word
+typedef struct {
+    uint64_t *words;
+    uint64_t *summary;
+    int size;
+} Index_Bitmap;
+
+Index_Bitmap bitmap_create(int size) {
+    Index_Bitmap bitmap;
+    int words = (size + 63) >> 6;
+    bitmap.words = (uint64_t *)calloc(words + 1, sizeof(uint64_t));
+    bitmap.summary = (uint64_t *)calloc(((words + 63) >> 6) + 1, sizeof(uint64_t));
+    if (bitmap.words == NULL || bitmap.summary == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    bitmap.size = size;
+    return bitmap;
+}
+
+void bitmap_free(Index_Bitmap *bitmap) {
+    free(bitmap->words);
+    free(bitmap->summary);
+}
+
+void bitmap_set(Index_Bitmap *bitmap, int index) {
+    int word = index >> 6;
+    bitmap->words[word] |= 1ULL << (index & 63);
+    bitmap->summary[word >> 6] |= 1ULL << (word & 63);
+}
+
+void bitmap_clear(Index_Bitmap *bitmap, int index) {
+    int word = index >> 6;
+    bitmap->words[word] &= ~(1ULL << (index & 63));
+    if (bitmap->words[word] == 0) bitmap->summary[word >> 6] &= ~(1ULL << (word & 63));
+}
+
+// Function to find the first set index at or after start (-1 if none)
+int bitmap_find_from(const Index_Bitmap *bitmap, int start) {
+    if (start >= bitmap->size) {
+        return -1;
+    }
+    int word = start >> 6;
+    uint64_t bits = bitmap->words[word] & (~0ULL << (start & 63));
+    if (bits != 0) {
+        return (word << 6) + __builtin_ctzll(bits);
+    }
+
+    // Use the summary to skip empty words
+    word++;
+    int words = (bitmap->size + 63) >> 6;
+    for (int group = word >> 6; (group << 6) < words; group++) {
+        uint64_t mask = bitmap->summary[group];
+        if (group == (word >> 6) && (word & 63) != 0) mask &= ~0ULL << (word & 63);
+        if (mask != 0) {
+            int found = (group << 6) + __builtin_ctzll(mask);
+            return (found << 6) + __builtin_ctzll(bitmap->words[found]);
+        }
+    }
+    return -1;
+}
+
+// Hierarchical timing wheel of process indexes, keyed by a time array
+//
+// Level l has WHEEL_SLOTS slots of WHEEL_SLOTS^l ticks each. An index goes to
+// the level of the highest 6-bit group in which its time differs from now, so
+// level 0 holds times within the current 64 ticks, exactly one time per slot,
+// and higher levels hold coarser and coarser ranges further ahead. When now
+// reaches a higher-level slot, its indexes move down to the levels that now
+// fit them. An index moves down at most once per level, so inserting and
+// expiring are O(1) amortised, against O(log n) for a heap. A 64-bit word per
+// level marks the occupied slots, so finding the next one is a single ctz.
+// Times must not go backwards: an index is inserted at or after now.
+
+#define WHEEL_BITS 6
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_LEVELS 6  // 36 bits ahead of now, more than an int time plus an int I/O time needs
+
+typedef struct {
+    uint64_t now;                           // Every time before now has been expired
+    uint64_t occupied[WHEEL_LEVELS];        // Bit s set if slot s of the level is not empty
+    int head[WHEEL_LEVELS][WHEEL_SLOTS];    // First index in each slot (-1 = empty)
+    int *next;                              // Next index in the same slot, per index
+    const uint64_t *time;                   // Expiry time of each index
+    int size;
+    bool earliest_known;                    // Whether earliest holds the smallest pending time
+    uint64_t earliest;
+} Timing_Wheel;
+
+// Function to empty a wheel and set its clock to zero
+void wheel_init(Timing_Wheel *wheel) {
+    memset(wheel->occupied, 0, sizeof(wheel->occupied));
+    memset(wheel->head, -1, sizeof(wheel->head));
+    wheel->now = 0;
+    wheel->size = 0;
+    wheel->earliest_known = false;
+}
+
+// Function to link an index into the slot its time falls in, seen from now
+void wheel_place(Timing_Wheel *wheel, int index) {
+    uint64_t time = wheel->time[index];
+    if (time < wheel->now) time = wheel->now;  // Already due
+    uint64_t differing = time ^ wheel->now;
+    int level = (differing == 0) ? 0 : (63 - __builtin_clzll(differing)) / WHEEL_BITS;
+    int slot = (int)(time >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1);
+    wheel->next[index] = wheel->head[level][slot];
+    wheel->head[level][slot] = index;
+    wheel->occupied[level] |= 1ULL << slot;
+}
+
+void wheel_insert(Timing_Wheel *wheel, int index) {
+    wheel_place(wheel, index);
+    uint64_t time = (wheel->time[index] < wheel->now) ? wheel->now : wheel->time[index];
+    if (wheel->size++ == 0) {
+        wheel->earliest = time;
+        wheel->earliest_known = true;
+    } else if (wheel->earliest_known && time < wheel->earliest) {
+        wheel->earliest = time;
+    }
+}
+
+// Function to take out an index whose time is at most until, moving the clock
+// forward as far as until; returns -1 once there are none left
+int wheel_pop(Timing_Wheel *wheel, uint64_t until) {
+    while (wheel->size > 0) {
+        if (wheel->occupied[0] != 0) {
+            // Level 0 slots are single times
+            int slot = __builtin_ctzll(wheel->occupied[0]);
+            uint64_t time = (wheel->now & ~(uint64_t)(WHEEL_SLOTS - 1)) | (uint64_t)slot;
+            if (time > until) {
+                break;
+            }
+            wheel->now = time;
+            int index = wheel->head[0][slot];
+            wheel->head[0][slot] = wheel->next[index];
+            if (wheel->head[0][slot] == -1) wheel->occupied[0] &= ~(1ULL << slot);
+            wheel->size--;
+            wheel->earliest_known = false;
+            return index;
+        }
+
+        // Move the first slot of the lowest occupied level down once the clock reaches it
+        int level = 1;
+        while (wheel->occupied[level] == 0) level++;
+        int slot = __builtin_ctzll(wheel->occupied[level]);
+        int shift = WHEEL_BITS * level;
+        uint64_t start = ((wheel->now >> (shift + WHEEL_BITS)) << (shift + WHEEL_BITS)) | ((uint64_t)slot << shift);
+        if (start > until) {
+            break;
+        }
+        wheel->now = start;
+        int index = wheel->head[level][slot];
+        wheel->head[level][slot] = -1;
+        wheel->occupied[level] &= ~(1ULL << slot);
+        while (index != -1) {
+            int next = wheel->next[index];
+            wheel_place(wheel, index);
+            index = next;
+        }
+    }
+
+    // Nothing else is due by until, so every pending time still fits its slot from there
+    if (until > wheel->now) wheel->now = until;
+    return -1;
+}
+
+// Function to return the smallest pending time (UINT64_MAX if the wheel is empty)
+uint64_t wheel_earliest(Timing_Wheel *wheel) {
+    if (wheel->size == 0) {
+        return UINT64_MAX;
+    }
+    if (!wheel->earliest_known) {
+        if (wheel->occupied[0] != 0) {
+            wheel->earliest = (wheel->now & ~(uint64_t)(WHEEL_SLOTS - 1)) | (uint64_t)__builtin_ctzll(wheel->occupied[0]);
+        } else {
+            // The first slot of the lowest occupied level holds it. The engine moves
+            // the clock there next, which moves the slot down, so scans stay rare
+            int level = 1;
+            while (wheel->occupied[level] == 0) level++;
+            int slot = __builtin_ctzll(wheel->occupied[level]);
+            wheel->earliest = UINT64_MAX;
+            for (int index = wheel->head[level][slot]; index != -1; index = wheel->next[index]) {
+                if (wheel->time[index] < wheel->earliest) wheel->earliest = wheel->time[index];
+            }
+        }
+        wheel->earliest_known = true;
+    }
+    return wheel->earliest;
+}
+
+// Function to step a splitmix64 generator, the seeded source of randomness for every mode
+uint64_t random_next(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Functions for MLFQ (multi-level feedback queue)
+//
+// Every level is a FIFO threaded through next[], and bit i of a 64-bit mask
+// is set while level i is non-empty, so the next process is the head of
+// level ctz(mask). New arrivals enter level 0; a process that uses up its
+// level's quantum moves one level down, and one preempted by an arrival
+// keeps its place at the head of its level. Every boost period all levels
+// are spliced onto level 0.
+
+#define MLFQ_MAX_LEVELS 64
+
+typedef struct {
+    int head[MLFQ_MAX_LEVELS];     // First process index on each level (-1 if empty)
+    int tail[MLFQ_MAX_LEVELS];     // Last process index on each level
+    uint64_t non_empty;            // Bit i set while level i has processes
+    int *next;                     // Next process on the same level
+} MLFQ_Queues;
+
+// Function to add a process at the back of a level
+void mlfq_push_back(MLFQ_Queues *queues, int level, int index) {
+    queues->next[index] = -1;
+    if (queues->head[level] == -1) {
+        queues->head[level] = index;
+    } else {
+        queues->next[queues->tail[level]] = index;
+    }
+    queues->tail[level] = index;
+    queues->non_empty |= 1ULL << level;
+}
+
+// Function to put a process back at the front of a level
+void mlfq_push_front(MLFQ_Queues *queues, int level, int index) {
+    queues->next[index] = queues->head[level];
+    if (queues->head[level] == -1) {
+        queues->tail[level] = index;
+    }
+    queues->head[level] = index;
+    queues->non_empty |= 1ULL << level;
+}
+
+// Function to take the first process off the highest non-empty level
+int mlfq_pop(MLFQ_Queues *queues, int *level) {
+    *level = __builtin_ctzll(queues->non_empty);
+    int index = queues->head[*level];
+    queues->head[*level] = queues->next[index];
+    if (queues->head[*level] == -1) {
+        queues->non_empty &= ~(1ULL << *level);
+    }
+    return index;
+}
+
+// Function to move every queued process to level 0, keeping level order
+void mlfq_boost(MLFQ_Queues *queues, int levels) {
+    for (int level = 1; level < levels; level++) {
+        if (queues->head[level] == -1) {
+            continue;
+        }
+        if (queues->head[0] == -1) {
+            queues->head[0] = queues->head[level];
+        } else {
+            queues->next[queues->tail[0]] = queues->head[level];
+        }
+        queues->tail[0] = queues->tail[level];
+        queues->head[level] = -1;
+    }
+    queues->non_empty = (queues->head[0] == -1) ? 0 : 1;
+}
+
+// Function to parse --quanta into one quantum per level; the last value repeats,
+// and without --quanta level i gets 2^(i+1), at most 2^30; returns false if a quantum is not positive
+bool fill_mlfq_quanta(const char *text, int quanta[], int levels) {
+    int count = 0;
+    while (text != NULL && *text != '\0' && count < levels) {
+        quanta[count++] = atoi(text);
+        text = strchr(text, ',');
+        if (text != NULL) text++;
+    }
+    for (int i = count; i < levels; i++) {
+        quanta[i] = (count > 0) ? quanta[count - 1] : (2 << (i < 29 ? i : 29));
+    }
+    for (int i = 0; i < levels; i++) {
+        if (quanta[i] <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to fill in the MLFQ quanta, exiting with an error if one is not positive
+void parse_mlfq_quanta(const char *text, int quanta[], int levels) {
+    if (!fill_mlfq_quanta(text, quanta, levels)) {
+        printf("Error: MLFQ quanta must be positive.\n");
+        exit(1);
+    }
+}
+
+// Function to simulate MLFQ scheduling over rows sorted by arrival time
+void simulateMLFQ(Process_For_Sim rows[], int n, int levels, const int quanta[], int boost_period) {
+    MLFQ_Queues queues;
+    int *level_of = (int *)malloc((n + 1) * sizeof(int));         // Level each process last ran at
+    int *quantum_left = (int *)malloc((n + 1) * sizeof(int));     // Unused part of its quantum
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));         // Completion order
+    queues.next = (int *)malloc((n + 1) * sizeof(int));
+    if (level_of == NULL || quantum_left == NULL || sequence == NULL || queues.next == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int level = 0; level < levels; level++) {
+        queues.head[level] = -1;
+    }
+    queues.non_empty = 0;
+
+    int current_time = 0, completed = 0, arrived = 0;
+    int next_boost = (boost_period > 0) ? boost_period : -1;
+
+    while (completed < n) {
+        // Admit everything that has arrived by now at the top level
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            level_of[arrived] = 0;
+            quantum_left[arrived] = quanta[0];
+            mlfq_push_back(&queues, 0, arrived);
+            arrived++;
+        }
+
+        if (next_boost != -1 && current_time >= next_boost) {
+            mlfq_boost(&queues, levels);
+            next_boost = (current_time / boost_period + 1) * boost_period;
+        }
+
+        if (queues.non_empty == 0) {
+            // Idle: jump to the next arrival
+            current_time = rows[arrived].arrival_time;
+            continue;
+        }
+
+        int level;
+        int index = mlfq_pop(&queues, &level);
+        if (level_of[index] != level) {
+            // Boosted since it last ran, so it starts the new level afresh
+            level_of[index] = level;
+            quantum_left[index] = quanta[level];
+        }
+
+        // Switching takes time; arrivals during it are queued before the process runs
+        int switch_time = charge_dispatch(index, rows[index].start_time != -1);
+        if (switch_time > 0) {
+            current_time += switch_time;
+            mlfq_push_front(&queues, level, index);
+            continue;
+        }
+
+        // Run until the quantum or the burst ends, or something preempts it
+        int slice = quantum_left[index];
+        if (rows[index].remaining_time < slice) slice = rows[index].remaining_time;
+        bool preempted = false;
+        if (level > 0 && arrived < n && rows[arrived].arrival_time < current_time + slice) {
+            slice = rows[arrived].arrival_time - current_time;  // A new arrival outranks it
+            preempted = true;
+        }
+        if (next_boost != -1 && next_boost < current_time + slice) {
+            slice = next_boost - current_time;
+            preempted = true;
+        }
+
+        run_sim_slice(&rows[index], current_time, slice);
+        current_time += slice;
+        quantum_left[index] -= slice;
+
+        // Arrivals during the slice queue ahead of the process coming off the CPU
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            level_of[arrived] = 0;
+            quantum_left[arrived] = quanta[0];
+            mlfq_push_back(&queues, 0, arrived);
+            arrived++;
+        }
+
+        if (rows[index].remaining_time == 0) {
+            finish_sim_row(&rows[index], current_time);
+            sequence[completed++] = rows[index].process_id;
+        } else if (quantum_left[index] == 0) {
+            // Used its whole quantum: demote
+            int next_level = (level + 1 < levels) ? level + 1 : level;
+            level_of[index] = next_level;
+            quantum_left[index] = quanta[next_level];
+            mlfq_push_back(&queues, next_level, index);
+        } else if (preempted) {
+            mlfq_push_front(&queues, level, index);
+        } else {
+            mlfq_push_back(&queues, level, index);
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(level_of);
+    free(quantum_left);
+    free(sequence);
+    free(queues.next);
+}
+
+// Functions for CFS (completely fair scheduling)
+//
+// Runnable processes sit in a red-black tree ordered by virtual runtime, which
+// grows more slowly the heavier a process's weight, and the leftmost node (cached)
+// runs next. The fifth CSV column is read as a nice value (-20..19, default 0)
+// and mapped to a weight with the Linux table. Each turn lasts the process's
+// weighted share of --latency, but never less than the minimum granularity.
+// Arrivals join at the current minimum virtual runtime and are picked up at the
+// end of the running slice.
+
+#define CFS_NICE_0_WEIGHT 1024
+#define CFS_VRUNTIME_SCALE (1ULL << 20)  // Fixed-point scale of virtual runtime
+
+// Weight for nice -20 ... 19, as in the Linux scheduler
+const int cfs_nice_to_weight[40] = {
+    88761, 71755, 56483, 46273, 36291, 29154, 23254, 18705, 14949, 11916,
+    9548, 7620, 6100, 4904, 3906, 3121, 2501, 1991, 1586, 1277,
+    1024, 820, 655, 526, 423, 335, 272, 215, 172, 137,
+    110, 87, 70, 56, 45, 36, 29, 23, 18, 15
+};
+
+// Red-black tree over process indexes; node nil (= n) is the shared black leaf
+typedef struct {
+    int *left, *right, *parent;
+    bool *red;
+    uint64_t *vruntime;           // Key of each process
+    int root;
+    int nil;
+    int leftmost;                 // Cached minimum (nil when empty)
+} CFS_Tree;
+
+// Function to order two processes by virtual runtime, then by position in the trace
+bool cfs_less(const CFS_Tree *tree, int a, int b) {
+    return tree->vruntime[a] < tree->vruntime[b] || (tree->vruntime[a] == tree->vruntime[b] && a < b);
+}
+
+void cfs_rotate_left(CFS_Tree *tree, int x) {
+    int y = tree->right[x];
+    tree->right[x] = tree->left[y];
+    if (tree->left[y] != tree->nil) tree->parent[tree->left[y]] = x;
+    tree->parent[y] = tree->parent[x];
+    if (tree->parent[x] == tree->nil) tree->root = y;
+    else if (x == tree->left[tree->parent[x]]) tree->left[tree->parent[x]] = y;
+    else tree->right[tree->parent[x]] = y;
+    tree->left[y] = x;
+    tree->parent[x] = y;
+}
+
+void cfs_rotate_right(CFS_Tree *tree, int x) {
+    int y = tree->left[x];
+    tree->left[x] = tree->right[y];
+    if (tree->right[y] != tree->nil) tree->parent[tree->right[y]] = x;
+    tree->parent[y] = tree->parent[x];
+    if (tree->parent[x] == tree->nil) tree->root = y;
+    else if (x == tree->right[tree->parent[x]]) tree->right[tree->parent[x]] = y;
+    else tree->left[tree->parent[x]] = y;
+    tree->right[y] = x;
+    tree->parent[x] = y;
+}
+
+// Function to insert process z, keyed on its current virtual runtime
+void cfs_insert(CFS_Tree *tree, int z) {
+    int y = tree->nil, x = tree->root;
+    while (x != tree->nil) {
+        y = x;
+        x = cfs_less(tree, z, x) ? tree->left[x] : tree->right[x];
+    }
+    tree->parent[z] = y;
+    if (y == tree->nil) tree->root = z;
+    else if (cfs_less(tree, z, y)) tree->left[y] = z;
+    else tree->right[y] = z;
+    tree->left[z] = tree->right[z] = tree->nil;
+    tree->red[z] = true;
+    if (tree->leftmost == tree->nil || cfs_less(tree, z, tree->leftmost)) tree->leftmost = z;
+
+    // Restore the red-black properties
+    while (tree->red[tree->parent[z]]) {
+        int p = tree->parent[z], g = tree->parent[p];
+        if (p == tree->left[g]) {
+            int uncle = tree->right[g];
+            if (tree->red[uncle]) {
+                tree->red[p] = tree->red[uncle] = false;
+                tree->red[g] = true;
+                z = g;
+            } else {
+                if (z == tree->right[p]) {
+                    z = p;
+                    cfs_rotate_left(tree, z);
+                    p = tree->parent[z];
+                }
+                tree->red[p] = false;
+                tree->red[g] = true;
+                cfs_rotate_right(tree, g);
+            }
+        } else {
+            int uncle = tree->left[g];
+            if (tree->red[uncle]) {
+                tree->red[p] = tree->red[uncle] = false;
+                tree->red[g] = true;
+                z = g;
+            } else {
+                if (z == tree->left[p]) {
+                    z = p;
+                    cfs_rotate_right(tree, z);
+                    p = tree->parent[z];
+                }
+                tree->red[p] = false;
+                tree->red[g] = true;
+                cfs_rotate_left(tree, g);
+            }
+        }
+    }
+    tree->red[tree->root] = false;
+}
+
+// Function to remove and return the process with the smallest virtual runtime
+int cfs_pop_leftmost(CFS_Tree *tree) {
+    int z = tree->leftmost;
+    int x = tree->right[z];  // The leftmost node has no left child
+
+    // Its successor is the minimum of its right subtree, or else its parent
+    if (x != tree->nil) {
+        int next = x;
+        while (tree->left[next] != tree->nil) next = tree->left[next];
+        tree->leftmost = next;
+    } else {
+        tree->leftmost = tree->parent[z];
+    }
+
+    // Splice z out, replacing it with its right child
+    tree->parent[x] = tree->parent[z];
+    if (tree->parent[z] == tree->nil) tree->root = x;
+    else tree->left[tree->parent[z]] = x;  // z is a left child
+
+    // Removing a black node leaves a "double black" at x to repair
+    if (!tree->red[z]) {
+        while (x != tree->root && !tree->red[x]) {
+            int p = tree->parent[x];
+            if (x == tree->left[p]) {
+                int w = tree->right[p];
+                if (tree->red[w]) {
+                    tree->red[w] = false;
+                    tree->red[p] = true;
+                    cfs_rotate_left(tree, p);
+                    w = tree->right[p];
+                }
+                if (!tree->red[tree->left[w]] && !tree->red[tree->right[w]]) {
+                    tree->red[w] = true;
+                    x = p;
+                } else {
+                    if (!tree->red[tree->right[w]]) {
+                        tree->red[tree->left[w]] = false;
+                        tree->red[w] = true;
+                        cfs_rotate_right(tree, w);
+                        w = tree->right[p];
+                    }
+                    tree->red[w] = tree->red[p];
+                    tree->red[p] = false;
+                    tree->red[tree->right[w]] = false;
+                    cfs_rotate_left(tree, p);
+                    x = tree->root;
+                }
+            } else {
+                int w = tree->left[p];
+                if (tree->red[w]) {
+                    tree->red[w] = false;
+                    tree->red[p] = true;
+                    cfs_rotate_right(tree, p);
+                    w = tree->left[p];
+                }
+                if (!tree->red[tree->right[w]] && !tree->red[tree->left[w]]) {
+                    tree->red[w] = true;
+                    x = p;
+                } else {
+                    if (!tree->red[tree->left[w]]) {
+                        tree->red[tree->right[w]] = false;
+                        tree->red[w] = true;
+                        cfs_rotate_left(tree, w);
+                        w = tree->left[p];
+                    }
+                    tree->red[w] = tree->red[p];
+                    tree->red[p] = false;
+                    tree->red[tree->left[w]] = false;
+                    cfs_rotate_right(tree, p);
+                    x = tree->root;
+                }
+            }
+        }
+        tree->red[x] = false;
+    }
+    tree->parent[tree->nil] = tree->nil;  // The fix-up may have written through nil
+    return z;
+}
+
+// Function to simulate CFS scheduling over rows sorted by arrival time
+void simulateCFS(Process_For_Sim rows[], int n, int min_granularity, int latency) {
+    CFS_Tree tree;
+    tree.left = (int *)malloc((n + 1) * sizeof(int));
+    tree.right = (int *)malloc((n + 1) * sizeof(int));
+    tree.parent = (int *)malloc((n + 1) * sizeof(int));
+    tree.red = (bool *)malloc((n + 1) * sizeof(bool));
+    tree.vruntime = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+    int *weight = (int *)malloc((n + 1) * sizeof(int));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    if (tree.left == NULL || tree.right == NULL || tree.parent == NULL || tree.red == NULL ||
+        tree.vruntime == NULL || weight == NULL || sequence == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    tree.nil = tree.root = tree.leftmost = n;
+    tree.red[n] = false;
+    tree.parent[n] = tree.left[n] = tree.right[n] = n;
+    tree.vruntime[n] = 0;
+
+    for (int i = 0; i < n; i++) {
+        int nice = rows[i].has_optional_column ? rows[i].optional_column : 0;
+        if (nice < -20) nice = -20;
+        if (nice > 19) nice = 19;
+        weight[i] = cfs_nice_to_weight[nice + 20];
+    }
+
+    int current_time = 0, completed = 0, arrived = 0;
+    long long total_weight = 0;     // Weight of every runnable process
+    uint64_t min_vruntime = 0;      // Never moves backwards
+
+    while (completed < n) {
+        // New arrivals start level with the least-served runnable process
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            tree.vruntime[arrived] = min_vruntime;
+            cfs_insert(&tree, arrived);
+            total_weight += weight[arrived];
+            arrived++;
+        }
+
+        if (tree.root == tree.nil) {
+            // Idle: jump to the next arrival
+            current_time = rows[arrived].arrival_time;
+            continue;
+        }
+
+        int index = cfs_pop_leftmost(&tree);
+        current_time += charge_dispatch(index, rows[index].start_time != -1);  // Switch to it
+
+        // Its share of the latency period, but at least the minimum granularity
+        long long slice = (long long)latency * weight[index] / total_weight;
+        if (slice < min_granularity) slice = min_granularity;
+        if (slice > rows[index].remaining_time) slice = rows[index].remaining_time;
+
+        run_sim_slice(&rows[index], current_time, (int)slice);
+        current_time += (int)slice;
+        tree.vruntime[index] += (uint64_t)slice * CFS_NICE_0_WEIGHT * CFS_VRUNTIME_SCALE / weight[index];
+
+        uint64_t smallest = tree.vruntime[index];
+        if (tree.leftmost != tree.nil && tree.vruntime[tree.leftmost] < smallest) smallest = tree.vruntime[tree.leftmost];
+        if (smallest > min_vruntime) min_vruntime = smallest;
+
+        if (rows[index].remaining_time == 0) {
+            finish_sim_row(&rows[index], current_time);
+            sequence[completed++] = rows[index].process_id;
+            total_weight -= weight[index];
+        } else {
+            cfs_insert(&tree, index);
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(tree.left);
+    free(tree.right);
+    free(tree.parent);
+    free(tree.red);
+    free(tree.vruntime);
+    free(weight);
+    free(sequence);
+}
+
+// Functions for preemptive priority with aging
+//
+// Priorities come from the fifth CSV column (lower = higher priority, as in
+// Process_For_Priority); rows without it fall back to the pid order used by
+// the non-preemptive mode (1 / pid, so the largest pid is level 0). Each level
+// is a FIFO bucket, and a two-level bitmap finds the best non-empty one.
+//
+// Aging is done a whole level at a time: every aging period the bucket at
+// level 0 is spliced in front of level 1 and the bucket array is rotated by
+// one, which moves every waiting process up a level in O(1). A process goes
+// back to its base level when it has run, and is preempted as soon as a
+// waiting process reaches a better level than the one it was dispatched at.
+// Levels are kept below AGING_MAX_LEVELS so the bucket array stays small;
+// a trace whose priorities (or pids, without the column) span more is refused.
+
+#define AGING_MAX_LEVELS 1000000
+
+typedef struct {
+    int buckets;                  // Physical buckets (highest base level + 2)
+    int offset;                   // Physical bucket holding level 0
+    int *head, *tail;             // FIFO of process indexes per bucket (-1 if empty)
+    int *next;                    // Next process in the same bucket
+    Index_Bitmap non_empty;       // Bit per non-empty bucket
+} Priority_Buckets;
+
+// Function to return the best (lowest) non-empty level, or -1 if every bucket is empty
+int bucket_best_level(const Priority_Buckets *queues) {
+    int bucket = bitmap_find_from(&queues->non_empty, queues->offset);
+    if (bucket != -1) {
+        return bucket - queues->offset;
+    }
+    bucket = bitmap_find_from(&queues->non_empty, 0);
+    return (bucket == -1 || bucket >= queues->offset) ? -1 : bucket + queues->buckets - queues->offset;
+}
+
+void bucket_push(Priority_Buckets *queues, int level, int index) {
+    int bucket = (level + queues->offset) % queues->buckets;
+    queues->next[index] = -1;
+    if (queues->head[bucket] == -1) {
+        queues->head[bucket] = index;
+        bitmap_set(&queues->non_empty, bucket);
+    } else {
+        queues->next[queues->tail[bucket]] = index;
+    }
+    queues->tail[bucket] = index;
+}
+
+int bucket_pop(Priority_Buckets *queues, int level) {
+    int bucket = (level + queues->offset) % queues->buckets;
+    int index = queues->head[bucket];
+    queues->head[bucket] = queues->next[index];
+    if (queues->head[bucket] == -1) {
+        bitmap_clear(&queues->non_empty, bucket);
+    }
+    return index;
+}
+
+// Function to move every waiting process up one level
+void bucket_age(Priority_Buckets *queues) {
+    int level0 = queues->offset;
+    int level1 = (queues->offset + 1) % queues->buckets;
+
+    // Level 0 has waited longest, so it goes in front of level 1
+    if (queues->head[level0] != -1) {
+        if (queues->head[level1] == -1) {
+            queues->tail[level1] = queues->tail[level0];
+            bitmap_set(&queues->non_empty, level1);
+        } else {
+            queues->next[queues->tail[level0]] = queues->head[level1];
+        }
+        queues->head[level1] = queues->head[level0];
+        queues->head[level0] = -1;
+        bitmap_clear(&queues->non_empty, level0);
+    }
+    queues->offset = level1;  // The emptied bucket becomes the last level
+}
+
+// Function to simulate preemptive priority scheduling with aging over rows sorted by arrival time;
+// returns false, without simulating, if the base levels span AGING_MAX_LEVELS or more
+bool simulate_priority_aging(Process_For_Sim rows[], int n, int aging_period) {
+    int *base_level = (int *)malloc((n + 1) * sizeof(int));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    if (base_level == NULL || sequence == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    // Base levels from the priority column, or from the pid when it is missing
+    int max_pid = 0, max_level = 0;
+    for (int i = 0; i < n; i++) {
+        if (rows[i].process_id > max_pid) max_pid = rows[i].process_id;
+    }
+    for (int i = 0; i < n; i++) {
+        long long level;
+        if (rows[i].has_optional_column) {
+            level = (rows[i].optional_column < 0) ? 0 : rows[i].optional_column;
+        } else {
+            level = (rows[i].process_id < 0) ? max_pid : (long long)max_pid - rows[i].process_id;
+        }
+        if (level >= AGING_MAX_LEVELS) {
+            free(base_level);
+            free(sequence);
+            return false;
+        }
+        base_level[i] = (int)level;
+        if (base_level[i] > max_level) max_level = base_level[i];
+    }
+
+    Priority_Buckets queues;
+    queues.buckets = max_level + 2;
+    queues.offset = 0;
+    queues.head = (int *)malloc(queues.buckets * sizeof(int));
+    queues.tail = (int *)malloc(queues.buckets * sizeof(int));
+    queues.next = (int *)malloc((n + 1) * sizeof(int));
+    queues.non_empty = bitmap_create(queues.buckets);
+    if (queues.head == NULL || queues.tail == NULL || queues.next == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < queues.buckets; i++) {
+        queues.head[i] = -1;
+    }
+
+    int current_time = 0, completed = 0, arrived = 0, waiting = 0;
+    int running = -1, running_level = 0;
+    long long next_aging = (aging_period > 0) ? aging_period : -1;
+
+    while (completed < n) {
+        // Admit arrivals at their base level
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            bucket_push(&queues, base_level[arrived], arrived);
+            arrived++;
+            waiting++;
+        }
+
+        // Age the waiting processes once per elapsed period
+        while (next_aging != -1 && next_aging <= current_time) {
+            if (waiting == 0) {
+                next_aging = ((long long)current_time / aging_period + 1) * aging_period;
+                break;
+            }
+            bucket_age(&queues);
+            next_aging += aging_period;
+        }
+
+        // Preempt the running process if something waiting now outranks it
+        if (running != -1) {
+            int best = bucket_best_level(&queues);
+            if (best != -1 && best < running_level) {
+                bucket_push(&queues, base_level[running], running);
+                waiting++;
+                running = -1;
+            }
+        }
+
+        if (running == -1) {
+            if (waiting == 0) {
+                // Idle: jump to the next arrival
+                current_time = rows[arrived].arrival_time;
+                continue;
+            }
+            running_level = bucket_best_level(&queues);
+            running = bucket_pop(&queues, running_level);
+            waiting--;
+
+            // Switching takes time; arrivals and aging during it are seen before it runs
+            int switch_time = charge_dispatch(running, rows[running].start_time != -1);
+            if (switch_time > 0) {
+                current_time += switch_time;
+                continue;
+            }
+        }
+
+        // Run until it finishes or the next arrival or aging step
+        long long until = (long long)current_time + rows[running].remaining_time;
+        if (arrived < n && rows[arrived].arrival_time < until) until = rows[arrived].arrival_time;
+        if (next_aging != -1 && waiting > 0 && next_aging < until) until = next_aging;
+
+        int slice = (int)(until - current_time);
+        run_sim_slice(&rows[running], current_time, slice);
+        current_time += slice;
+
+        if (rows[running].remaining_time == 0) {
+            finish_sim_row(&rows[running], current_time);
+            sequence[completed++] = rows[running].process_id;
+            running = -1;
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(base_level);
+    free(sequence);
+    free(queues.head);
+    free(queues.tail);
+    free(queues.next);
+    bitmap_free(&queues.non_empty);
+    return true;
+}
+
+// Functions for stride and lottery scheduling
+//
+// Both hand out quanta in proportion to tickets, taken from the fifth CSV
+// column (default 100). Stride runs the process with the smallest pass from a
+// min-heap and advances its pass by stride = STRIDE_ONE / tickets per full
+// quantum; arrivals join at the smallest pass currently queued. Lottery keeps
+// the tickets of runnable processes in a Fenwick tree and draws the winner of
+// each quantum from --seed in O(log n).
+
+#define DEFAULT_TICKETS 100
+#define STRIDE_ONE (1ULL << 32)
+
+// Function to read the tickets of each row from the optional column
+int *read_tickets(Process_For_Sim rows[], int n) {
+    int *tickets = (int *)malloc((n + 1) * sizeof(int));
+    if (tickets == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        tickets[i] = rows[i].has_optional_column ? rows[i].optional_column : DEFAULT_TICKETS;
+        if (tickets[i] < 1) tickets[i] = 1;
+    }
+    return tickets;
+}
+
+// Function to simulate stride scheduling over rows sorted by arrival time
+void simulate_stride(Process_For_Sim rows[], int n, int quantum) {
+    int *tickets = read_tickets(rows, n);
+    uint64_t *pass = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    if (pass == NULL || sequence == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    Index_Heap heap = heap_create(n, pass);
+
+    int current_time = 0, completed = 0, arrived = 0;
+    uint64_t global_pass = 0;  // Pass of the process that ran last
+
+    while (completed < n) {
+        // New arrivals start at the smallest pass in the queue so they neither starve nor monopolise
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            pass[arrived] = (heap.size > 0 && pass[heap.items[0]] > global_pass) ? pass[heap.items[0]] : global_pass;
+            heap_push(&heap, arrived);
+            arrived++;
+        }
+
+        if (heap.size == 0) {
+            // Idle: jump to the next arrival
+            current_time = rows[arrived].arrival_time;
+            continue;
+        }
+
+        int index = heap_pop(&heap);
+        current_time += charge_dispatch(index, rows[index].start_time != -1);  // Switch to it
+        int slice = (rows[index].remaining_time < quantum) ? rows[index].remaining_time : quantum;
+        run_sim_slice(&rows[index], current_time, slice);
+        current_time += slice;
+
+        // A partial quantum advances the pass by the same fraction of the stride
+        global_pass = pass[index];
+        pass[index] += (STRIDE_ONE / tickets[index]) * slice / quantum;
+
+        if (rows[index].remaining_time == 0) {
+            finish_sim_row(&rows[index], current_time);
+            sequence[completed++] = rows[index].process_id;
+        } else {
+            // Arrivals during the slice are queued first, as in the loop above
+            while (arrived < n && rows[arrived].arrival_time <= current_time) {
+                pass[arrived] = (heap.size > 0 && pass[heap.items[0]] > global_pass) ? pass[heap.items[0]] : global_pass;
+                heap_push(&heap, arrived);
+                arrived++;
+            }
+            heap_push(&heap, index);
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(tickets);
+    free(pass);
+    free(sequence);
+    free(heap.items);
+}
+
+// Function to add delta tickets at position index of a Fenwick tree of size n
+void fenwick_add(long long tree[], int n, int index, long long delta) {
+    for (int i = index + 1; i <= n; i += i & -i) {
+        tree[i] += delta;
+    }
+}
+
+// Function to find the position whose ticket range holds ticket number target
+int fenwick_find(const long long tree[], int n, long long target) {
+    int position = 0;
+    int step = 1;
+    while (step * 2 <= n) step *= 2;
+    for (; step > 0; step /= 2) {
+        if (position + step <= n && tree[position + step] <= target) {
+            position += step;
+            target -= tree[position];
+        }
+    }
+    return position;  // Zero-based index of the winner
+}
+
+// Function to simulate lottery scheduling over rows sorted by arrival time
+void simulate_lottery(Process_For_Sim rows[], int n, int quantum, uint64_t seed) {
+    int *tickets = read_tickets(rows, n);
+    long long *tree = (long long *)calloc(n + 1, sizeof(long long));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    if (tree == NULL || sequence == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    uint64_t random_state = seed;
+    int current_time = 0, completed = 0, arrived = 0;
+    long long total_tickets = 0;
+
+    while (completed < n) {
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            fenwick_add(tree, n, arrived, tickets[arrived]);
+            total_tickets += tickets[arrived];
+            arrived++;
+        }
+
+        if (total_tickets == 0) {
+            // Idle: jump to the next arrival
+            current_time = rows[arrived].arrival_time;
+            continue;
+        }
+
+        int index = fenwick_find(tree, n, (long long)(random_next(&random_state) % (uint64_t)total_tickets));
+        current_time += charge_dispatch(index, rows[index].start_time != -1);  // Switch to it
+        int slice = (rows[index].remaining_time < quantum) ? rows[index].remaining_time : quantum;
+        run_sim_slice(&rows[index], current_time, slice);
+        current_time += slice;
+
+        if (rows[index].remaining_time == 0) {
+            finish_sim_row(&rows[index], current_time);
+            sequence[completed++] = rows[index].process_id;
+            fenwick_add(tree, n, index, -tickets[index]);
+            total_tickets -= tickets[index];
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(tickets);
+    free(tree);
+    free(sequence);
+}
+
+// Functions for EDF (earliest deadline first)
+//
+// The fifth CSV column is a relative deadline; the absolute deadline is
+// arrival + deadline, and rows without one sort after every row that has one
+// and are left out of the deadline statistics. A negative relative deadline
+// counts as none. Ready processes sit in a min-heap keyed on absolute
+// deadline. In the preemptive mode an arrival with an earlier deadline takes
+// the CPU straight away.
+
+#define NO_DEADLINE UINT64_MAX
+
+// Function to tell whether a row has a deadline (a fifth column that is not negative)
+bool row_has_deadline(const Process_For_Sim *row) {
+    return row->has_optional_column && row->optional_column >= 0;
+}
+
+// Function to simulate EDF scheduling over rows sorted by arrival time
+void simulate_edf(Process_For_Sim rows[], int n, bool preemptive) {
+    uint64_t *deadline = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    if (deadline == NULL || sequence == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        deadline[i] = row_has_deadline(&rows[i]) ? (uint64_t)((long long)rows[i].arrival_time + rows[i].optional_column - (long long)INT32_MIN) : NO_DEADLINE;
+    }
+    Index_Heap heap = heap_create(n, deadline);
+
+    int current_time = 0, completed = 0, arrived = 0, running = -1;
+
+    while (completed < n) {
+        while (arrived < n && rows[arrived].arrival_time <= current_time) {
+            heap_push(&heap, arrived);
+            arrived++;
+        }
+
+        // An earlier deadline preempts the running process
+        if (preemptive && running != -1 && heap.size > 0 && heap_less(&heap, heap.items[0], running)) {
+            heap_push(&heap, running);
+            running = -1;
+        }
+
+        if (running == -1) {
+            if (heap.size == 0) {
+                // Idle: jump to the next arrival
+                current_time = rows[arrived].arrival_time;
+                continue;
+            }
+            running = heap_pop(&heap);
+
+            // Switching takes time; an arrival during it can still preempt before it runs
+            int switch_time = charge_dispatch(running, rows[running].start_time != -1);
+            if (switch_time > 0) {
+                current_time += switch_time;
+                continue;
+            }
+        }
+
+        // Run to completion, or in the preemptive mode until the next arrival
+        int slice = rows[running].remaining_time;
+        if (preemptive && arrived < n && rows[arrived].arrival_time - current_time < slice) {
+            slice = rows[arrived].arrival_time - current_time;
+        }
+        run_sim_slice(&rows[running], current_time, slice);
+        current_time += slice;
+
+        if (rows[running].remaining_time == 0) {
+            finish_sim_row(&rows[running], current_time);
+            sequence[completed++] = rows[running].process_id;
+            running = -1;
+        }
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(deadline);
+    free(sequence);
+    free(heap.items);
+}
+
+int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Function to report deadline misses and the lateness distribution of the rows that had a deadline,
+// as text after the table or as a record after the summary of the structured formats
+void display_deadline_statistics(Process_For_Sim rows[], int n) {
+    int *lateness = (int *)malloc((n + 1) * sizeof(int));
+    if (lateness == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    int count = 0, misses = 0;
+    long long total_lateness = 0;
+    for (int i = 0; i < n; i++) {
+        if (!row_has_deadline(&rows[i])) {
+            continue;
+        }
+        lateness[count] = rows[i].completion_time - (rows[i].arrival_time + rows[i].optional_column);
+        total_lateness += lateness[count];
+        if (lateness[count] > 0) misses++;
+        count++;
+    }
+
+    if (count > 0) {
+        qsort(lateness, count, sizeof(int), compare_ints);
+    }
+    if (options.output != OUTPUT_TABLE) {
+        Result_Deadlines deadlines = {0};
+        if (count > 0) {
+            deadlines = (Result_Deadlines){count, misses, lateness[0], (double)total_lateness / count,
+                                           lateness[(count - 1) / 2], lateness[(int)((count - 1) * 0.9)],
+                                           lateness[(int)((count - 1) * 0.99)], lateness[count - 1]};
+        }
+        write_result_deadlines(&deadlines);
+        free(lateness);
+        return;
+    }
+    if (count == 0) {
+        printf("\nDeadline Misses: no rows have a deadline\n");
+        free(lateness);
+        return;
+    }
+
+    printf("\nDeadline Misses: %d of %d (%.2f%%)\n", misses, count, 100.0 * misses / count);
+    printf("Lateness: min %d, mean %.2f, p50 %d, p90 %d, p99 %d, max %d ms\n",
+           lateness[0], (double)total_lateness / count, lateness[(count - 1) / 2],
+           lateness[(int)((count - 1) * 0.9)], lateness[(int)((count - 1) * 0.99)], lateness[count - 1]);
+
+    // Tardiness of the late rows in power-of-two buckets
+    if (misses > 0) {
+        int buckets[31] = {0};  // [2^k, 2^(k+1)), the last one up to INT_MAX
+        for (int i = count - misses; i < count; i++) {
+            int bucket = 0;
+            while (bucket < 30 && (1LL << (bucket + 1)) <= lateness[i]) bucket++;
+            buckets[bucket]++;
+        }
+        printf("Tardiness histogram:\n");
+        for (int bucket = 0; bucket < 31; bucket++) {
+            if (buckets[bucket] > 0) {
+                printf("  %10lld - %-10lld : %d\n", 1LL << bucket, (bucket < 30) ? (2LL << bucket) - 1 : (long long)INT_MAX,
+                       buckets[bucket]);
+            }
+        }
+    }
+    free(lateness);
+}
+
+// Single-producer, single-consumer ring buffer
+//
+// Connects the stages of the pipelined mode. Items are copied in and out by
+// value. Each side owns one position and keeps a cached copy of the other
+// side's. It only loads the shared position again, with acquire ordering,
+// when the ring looks full or empty. The two positions sit on their own
+// cache lines. A side that has to wait yields the CPU.
+
+#define RING_CAPACITY 4096  // Items; a power of two
+
+typedef struct {
+    char *items;
+    size_t item_size;
+    _Alignas(64) _Atomic size_t tail;    // Next slot to fill, written by the producer
+    size_t cached_head;                  // Producer's copy of head
+    _Atomic bool closed;                 // The producer has pushed its last item
+    _Alignas(64) _Atomic size_t head;    // Next slot to empty, written by the consumer
+    size_t cached_tail;                  // Consumer's copy of tail
+} Spsc_Ring;
+
+// Function to set up an empty ring for items of item_size bytes
+void ring_init(Spsc_Ring *ring, size_t item_size) {
+    ring->items = (char *)malloc(RING_CAPACITY * item_size);
+    if (ring->items == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    ring->item_size = item_size;
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->closed, false);
+    ring->cached_head = 0;
+    ring->cached_tail = 0;
+}
+
+// Function to copy an item into the ring, waiting while it is full (producer only)
+void ring_push(Spsc_Ring *ring, const void *item) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    while (tail - ring->cached_head == RING_CAPACITY) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        if (tail - ring->cached_head == RING_CAPACITY) {
+            sched_yield();
+        }
+    }
+    memcpy(ring->items + (tail & (RING_CAPACITY - 1)) * ring->item_size, item, ring->item_size);
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+}
+
+// Function to mark that no more items will be pushed (producer only)
+void ring_close(Spsc_Ring *ring) {
+    atomic_store_explicit(&ring->closed, true, memory_order_release);
+}
+
+// Function to copy the next item out of the ring, waiting while it is empty;
+// returns false once the ring is empty and closed (consumer only)
+bool ring_pop(Spsc_Ring *ring, void *item) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    while (head == ring->cached_tail) {
+        // Read closed before tail, so a push made before ring_close is never missed
+        bool closed = atomic_load_explicit(&ring->closed, memory_order_acquire);
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+        if (head == ring->cached_tail) {
+            if (closed) {
+                return false;
+            }
+            sched_yield();
+        }
+    }
+    memcpy(item, ring->items + (head & (RING_CAPACITY - 1)) * ring->item_size, ring->item_size);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Functions for multi-burst processes with I/O
+//
+// With --io, rows that share a pid are one process's successive CPU bursts
+// rather than independent jobs. Between bursts the process is blocked on I/O:
+// a burst becomes ready at the later of its own arrival time and the previous
+// burst's completion plus the I/O time. Blocked bursts, whether waiting for their
+// arrival or for I/O, wait in a timing wheel keyed on their wake-up time. Only
+// the running burst has a quantum, so its expiry is computed, not queued.
+//
+// Ready bursts are chosen the way the matching classic simulator chooses them,
+// so without I/O (one row per pid) the schedule is the same: FCFS, SJF and
+// Priority use a min-heap keyed on ready time, burst and 1 / pid; RR cycles
+// through the ready rows in trace order like simulateRR's pointer, using a
+// bitmap of ready rows; SRT keeps simulate_preemptive_srt's float predicted
+// remaining time and tie-breaks. EDF keys the heap on arrival plus the fifth
+// CSV column, as simulate_edf does. Waiting time counts time ready, not time
+// blocked on I/O.
+//
+// The loop is written once, generic in the policy (its ready-queue key,
+// whether a wake-up can preempt, whether there is a quantum), and is always
+// inlined into one simulate_multiburst_<policy> function per policy with the
+// policy as a constant. The compiler then drops every branch belonging to the
+// other policies, the way a template would, and there is no indirect call. A
+// new policy needs an enum value, its cases in the policy_* functions and one
+// MULTIBURST_ENGINE line.
+
+typedef enum {
+    POLICY_FCFS,
+    POLICY_SJF,
+    POLICY_PRIORITY,
+    POLICY_RR,
+    POLICY_SRT,
+    POLICY_EDF
+} Policy;
+
+// Always inlined into its caller, so constant policy arguments fold away
+#define ENGINE_INLINE static inline __attribute__((always_inline))
+
+// Function to map an algorithm name to a policy; returns false if the engine does not run it
+bool policy_from_name(const char *name, Policy *policy) {
+    if (strcmp(name, "FCFS") == 0) *policy = POLICY_FCFS;
+    else if (strcmp(name, "SJF") == 0) *policy = POLICY_SJF;
+    else if (strcmp(name, "Priority") == 0) *policy = POLICY_PRIORITY;
+    else if (strcmp(name, "RR") == 0) *policy = POLICY_RR;
+    else if (strcmp(name, "SRT") == 0) *policy = POLICY_SRT;
+    else if (strcmp(name, "EDF") == 0) *policy = POLICY_EDF;
+    else return false;
+    return true;
+}
+
+// Function to map a float onto an unsigned key with the same ordering
+uint64_t float_order_key(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? (uint64_t)(~bits) : (uint64_t)(bits | 0x80000000u);
+}
+
+// Function to take k ticks off a predicted remaining time one at a time, rounding
+// exactly as simulate_preemptive_srt does when it goes negative
+float srt_run_down(float predicted, int ticks) {
+    for (int k = 0; k < ticks; k++) {
+        predicted--;
+    }
+    return predicted;
+}
+
+// Function to tell whether a burst waking up can take the CPU from the running one
+ENGINE_INLINE bool policy_preemptive(Policy policy) {
+    return policy == POLICY_SRT || policy == POLICY_EDF;
+}
+
+// Function to tell whether the running burst gives up the CPU after a quantum
+ENGINE_INLINE bool policy_has_quantum(Policy policy) {
+    return policy == POLICY_RR;
+}
+
+// Function to give the ready-queue key of a burst becoming ready (lower runs first)
+ENGINE_INLINE uint64_t policy_ready_key(Policy policy, const Process_For_Sim *row, uint64_t ready_key, float predicted) {
+    switch (policy) {
+    case POLICY_FCFS: return ready_key;
+    case POLICY_SJF: return (uint64_t)(row->burst_time - (long long)INT32_MIN);
+    case POLICY_PRIORITY: return float_order_key((float) 1.0 / (row->process_id));
+    case POLICY_SRT: return float_order_key(predicted);
+    case POLICY_EDF:
+        return row_has_deadline(row) ? (uint64_t)((long long)row->arrival_time + row->optional_column - (long long)INT32_MIN) : UINT64_MAX;
+    case POLICY_RR: break;
+    }
+    return 0;
+}
+
+// Where the multi-burst engine takes its rows from and sends its completions:
+// an array already read and sorted, or in pipelined mode the reader thread's
+// ring, with completions going to the writer thread's ring
+typedef struct {
+    Process_For_Sim *rows;   // Rows taken so far, in arrival order
+    int count;               // Rows taken so far
+    int capacity;            // Room in rows
+    int total;               // Rows in the array (array source only)
+    bool exhausted;          // Every row has been taken
+    Spsc_Ring *input;        // Pipelined: rows from the reader thread (NULL: array source)
+    Spsc_Ring *output;       // Pipelined: completed rows for the writer thread (NULL: print the sequence)
+} Row_Stream;
+
+// Per-pid state of the multi-burst engine
+typedef struct {
+    int pid;
+    int last_row;                   // Latest row of the pid taken so far
+    bool last_done;                 // Whether that row has completed
+    int last_completion;            // When it completed
+    Burst_Prediction prediction;    // SRT: prediction for the pid's next burst
+} Pid_State;
+
+// Hash table from pid to Pid_State (open addressing, linear probing)
+typedef struct {
+    int *slots;          // Index into states, -1 if empty
+    int slot_count;      // A power of two, at least twice count
+    Pid_State *states;
+    int count;
+    int capacity;
+} Pid_Table;
+
+// Function to find pid's state, adding a fresh one if the pid is new
+Pid_State *pid_table_get(Pid_Table *table, int pid) {
+    if (2 * (table->count + 1) > table->slot_count) {
+        // Grow the slot array and re-insert every pid
+        int slot_count = (table->slot_count == 0) ? 64 : 2 * table->slot_count;
+        int *slots = (int *)malloc(slot_count * sizeof(int));
+        if (slots == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        for (int i = 0; i < slot_count; i++) {
+            slots[i] = -1;
+        }
+        for (int s = 0; s < table->count; s++) {
+            uint32_t i = ((uint32_t)table->states[s].pid * 2654435761u) & (slot_count - 1);
+            while (slots[i] != -1) i = (i + 1) & (slot_count - 1);
+            slots[i] = s;
+        }
+        free(table->slots);
+        table->slots = slots;
+        table->slot_count = slot_count;
+    }
+
+    uint32_t i = ((uint32_t)pid * 2654435761u) & (table->slot_count - 1);
+    while (table->slots[i] != -1) {
+        if (table->states[table->slots[i]].pid == pid) {
+            return &table->states[table->slots[i]];
+        }
+        i = (i + 1) & (table->slot_count - 1);
+    }
+
+    if (table->count == table->capacity) {
+        table->capacity = (table->capacity == 0) ? 64 : 2 * table->capacity;
+        table->states = (Pid_State *)realloc(table->states, table->capacity * sizeof(Pid_State));
+        if (table->states == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    Pid_State *state = &table->states[table->count];
+    memset(state, 0, sizeof(*state));
+    state->pid = pid;
+    state->last_row = -1;
+    state->prediction.tau = 10;  // Same initial prediction main gives every SRT row
+    table->slots[i] = table->count++;
+    return state;
+}
+
+// Per-row arrays and queues of the multi-burst engine, grown with the stream
+typedef struct {
+    int *next_burst;        // Next row of the same pid (-1 if none yet)
+    int *ready_time;        // When each burst became ready
+    uint64_t *key;          // Ready-queue key
+    uint64_t *wake;         // Blocked-queue key
+    int *wheel_next;        // Links of the blocked queue's slots
+    float *predicted;       // SRT: predicted remaining time
+    int capacity;
+    Timing_Wheel blocked;   // Bursts waiting for their arrival or I/O, by wake-up time
+    Index_Heap ready;       // Ready bursts, by key (all policies but RR)
+    Index_Bitmap ready_rows;    // RR: rows that are ready
+} Multiburst_Queues;
+
+// Function to make room in the engine's per-row arrays for capacity rows
+void multiburst_reserve(Multiburst_Queues *queues, int capacity) {
+    if (capacity <= queues->capacity) {
+        return;
+    }
+    queues->next_burst = (int *)realloc(queues->next_burst, (capacity + 1) * sizeof(int));
+    queues->ready_time = (int *)realloc(queues->ready_time, (capacity + 1) * sizeof(int));
+    queues->key = (uint64_t *)realloc(queues->key, (capacity + 1) * sizeof(uint64_t));
+    queues->wake = (uint64_t *)realloc(queues->wake, (capacity + 1) * sizeof(uint64_t));
+    queues->wheel_next = (int *)realloc(queues->wheel_next, (capacity + 1) * sizeof(int));
+    queues->predicted = (float *)realloc(queues->predicted, (capacity + 1) * sizeof(float));
+    queues->ready.items = (int *)realloc(queues->ready.items, (capacity + 1) * sizeof(int));
+    if (queues->next_burst == NULL || queues->ready_time == NULL || queues->key == NULL || queues->wake == NULL ||
+        queues->wheel_next == NULL || queues->predicted == NULL || queues->ready.items == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    queues->blocked.time = queues->wake;
+    queues->blocked.next = queues->wheel_next;
+    queues->ready.key = queues->key;
+
+    // A bigger bitmap with the same bits set
+    Index_Bitmap ready_rows = bitmap_create(capacity);
+    if (queues->capacity > 0) {
+        for (int i = bitmap_find_from(&queues->ready_rows, 0); i != -1; i = bitmap_find_from(&queues->ready_rows, i + 1)) {
+            bitmap_set(&ready_rows, i);
+        }
+        bitmap_free(&queues->ready_rows);
+    }
+    queues->ready_rows = ready_rows;
+    queues->capacity = capacity;
+}
+
+// Function to take the next row from the stream into rows[count]; false when there are none left
+bool stream_take(Row_Stream *stream) {
+    if (stream->input == NULL) {
+        if (stream->count == stream->total) {
+            return false;
+        }
+        stream->count++;
+        return true;
+    }
+    if (stream->count == stream->capacity) {
+        stream->capacity = (stream->capacity == 0) ? 1024 : 2 * stream->capacity;
+        stream->rows = (Process_For_Sim *)realloc(stream->rows, stream->capacity * sizeof(Process_For_Sim));
+        if (stream->rows == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    if (!ring_pop(stream->input, &stream->rows[stream->count])) {
+        return false;
+    }
+    stream->count++;
+    return true;
+}
+
+// Function to put a burst in the blocked queue until its wake-up time
+void multiburst_block(Multiburst_Queues *queues, int index, long long wake_time) {
+    queues->wake[index] = (uint64_t)(wake_time - INT32_MIN);
+    wheel_insert(&queues->blocked, index);
+}
+
+// Function to take rows from the stream until one arrives after time (or none are left).
+// A row whose pid still has an unfinished row is chained behind it; any other row
+// is blocked until its arrival, or until the I/O after the pid's last burst is done
+ENGINE_INLINE void multiburst_take_through(Row_Stream *stream, Multiburst_Queues *queues, Pid_Table *pids,
+                                           long long time, int io_time) {
+    while (!stream->exhausted && (stream->count == 0 || stream->rows[stream->count - 1].arrival_time <= time)) {
+        if (!stream_take(stream)) {
+            stream->exhausted = true;
+            break;
+        }
+        int i = stream->count - 1;
+        if (i >= queues->capacity) {
+            multiburst_reserve(queues, 2 * queues->capacity);
+        }
+        Process_For_Sim *row = &stream->rows[i];
+        Pid_State *state = pid_table_get(pids, row->process_id);
+        queues->next_burst[i] = -1;
+        if (state->last_row != -1 && !state->last_done) {
+            queues->next_burst[state->last_row] = i;
+        } else {
+            long long wake_time = row->arrival_time;
+            if (state->last_row != -1 && (long long)state->last_completion + io_time > wake_time) {
+                wake_time = (long long)state->last_completion + io_time;
+            }
+            multiburst_block(queues, i, wake_time);
+        }
+        state->last_row = i;
+        state->last_done = false;
+    }
+}
+
+// Function to simulate a stream of multi-burst processes under a policy known at compile time
+ENGINE_INLINE void multiburst_loop(Row_Stream *stream, const Policy policy, int quantum, float alpha, int io_time) {
+    Multiburst_Queues queues;
+    memset(&queues, 0, sizeof(queues));
+    wheel_init(&queues.blocked);
+    multiburst_reserve(&queues, (stream->capacity > 0) ? stream->capacity : 1024);
+    Pid_Table pids;
+    memset(&pids, 0, sizeof(pids));
+    int *sequence = NULL;
+    if (stream->output == NULL) {
+        sequence = (int *)malloc((stream->total + 1) * sizeof(int));
+        if (sequence == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+
+    // Short names for the arrays the loop uses on every step
+    uint64_t *key = queues.key, *wake = queues.wake;
+    int ready_count = 0;
+    int current_time = 0, completed = 0, running = -1, pointer = -1;
+
+    while (true) {
+        multiburst_take_through(stream, &queues, &pids, current_time, io_time);
+        if (stream->exhausted && completed == stream->count) {
+            break;
+        }
+        Process_For_Sim *rows = stream->rows;
+        key = queues.key;
+        wake = queues.wake;
+
+        // Move every burst whose wake-up time has come into the ready queue
+        int i;
+        while ((i = wheel_pop(&queues.blocked, (uint64_t)((long long)current_time - INT32_MIN))) != -1) {
+            queues.ready_time[i] = (int)((long long)wake[i] + INT32_MIN);
+            if (policy == POLICY_SRT) {
+                queues.predicted[i] = pid_table_get(&pids, rows[i].process_id)->prediction.tau;
+            }
+            key[i] = policy_ready_key(policy, &rows[i], wake[i], queues.predicted[i]);
+            if (policy == POLICY_RR) {
+                bitmap_set(&queues.ready_rows, i);
+            } else {
+                heap_push(&queues.ready, i);
+            }
+            ready_count++;
+        }
+
+        // SRT and EDF: a ready burst with a smaller key (shorter predicted
+        // remaining time, earlier deadline) preempts
+        if (policy_preemptive(policy) && running != -1 && queues.ready.size > 0) {
+            if (policy == POLICY_SRT) {
+                key[running] = float_order_key(queues.predicted[running]);
+            }
+            if (heap_less(&queues.ready, queues.ready.items[0], running)) {
+                heap_push(&queues.ready, running);
+                running = -1;
+            }
+        }
+
+        if (running == -1) {
+            if (ready_count == 0) {
+                // Idle: jump to the next arrival or I/O completion. The last row
+                // taken arrives no later than any row still to be taken.
+                long long next_event = LLONG_MAX;
+                if (queues.blocked.size > 0) next_event = (long long)wheel_earliest(&queues.blocked) + INT32_MIN;
+                if (!stream->exhausted && rows[stream->count - 1].arrival_time < next_event) {
+                    next_event = rows[stream->count - 1].arrival_time;
+                }
+                current_time = (int)next_event;
+                continue;
+            }
+            PROFILE_DECLARE(decision_start);
+            PROFILE_START(decision_start);
+            if (policy == POLICY_RR) {
+                // Next ready row after the last one that ran, wrapping to the start
+                running = bitmap_find_from(&queues.ready_rows, pointer + 1);
+                if (running == -1) running = bitmap_find_from(&queues.ready_rows, 0);
+            } else {
+                running = heap_pop(&queues.ready);
+            }
+            PROFILE_STOP(PROFILE_ENGINE_POP, decision_start, ready_count);
+
+            // Switching takes time; wake-ups during it are seen before the burst runs
+            int switch_time = charge_dispatch(running, rows[running].start_time != -1);
+            if (switch_time > 0) {
+                current_time += switch_time;
+                continue;
+            }
+        }
+
+        // How long it runs before the next scheduling decision
+        int slice = rows[running].remaining_time;
+        if (policy_has_quantum(policy) && quantum < slice) {
+            slice = quantum;
+        }
+        if (policy_preemptive(policy)) {
+            // Every arrival inside the slice has to be in the blocked queue to cut it short
+            multiburst_take_through(stream, &queues, &pids, (long long)current_time + slice - 1, io_time);
+            rows = stream->rows;
+            wake = queues.wake;
+            if (queues.blocked.size > 0) {
+                long long next_event = (long long)wheel_earliest(&queues.blocked) + INT32_MIN;
+                if (next_event - current_time < slice) slice = (int)(next_event - current_time);
+            }
+        }
+
+        run_sim_slice(&rows[running], current_time, slice);
+        current_time += slice;
+        if (policy == POLICY_SRT) {
+            queues.predicted[running] = srt_run_down(queues.predicted[running], slice);
+        }
+        if (policy == POLICY_RR) {
+            pointer = running;
+        }
+
+        if (rows[running].remaining_time == 0) {
+            Process_For_Sim *row = &rows[running];
+            row->completion_time = current_time;
+            row->waiting_time = (current_time - queues.ready_time[running]) - row->burst_time;
+            record_completion(row->arrival_time, row->burst_time, current_time);
+
+            // Response time as the matching classic simulator computes it
+            if (policy == POLICY_FCFS || policy == POLICY_SJF) {
+                row->response_time = row->start_time + row->time_until_first_response;
+            } else if (policy == POLICY_PRIORITY || policy == POLICY_SRT) {
+                row->response_time = row->waiting_time + row->time_until_first_response;
+            }
+            Pid_State *state = pid_table_get(&pids, row->process_id);
+            if (policy == POLICY_SRT) {
+                update_prediction(&state->prediction, row->burst_time, alpha);
+            }
+            if (policy == POLICY_RR) {
+                bitmap_clear(&queues.ready_rows, running);
+            }
+            if (stream->output != NULL) {
+                ring_push(stream->output, row);
+            } else {
+                sequence[completed] = row->process_id;
+            }
+            completed++;
+            ready_count--;
+
+            // The pid's next burst waits for its I/O to finish
+            int next = queues.next_burst[running];
+            if (next != -1) {
+                long long wake_time = (long long)current_time + io_time;
+                if (rows[next].arrival_time > wake_time) wake_time = rows[next].arrival_time;
+                multiburst_block(&queues, next, wake_time);
+            }
+            if (state->last_row == running) {
+                state->last_done = true;
+                state->last_completion = current_time;
+            }
+            running = -1;
+        } else if (policy == POLICY_RR) {
+            running = -1;  // Stays in the ready bitmap until its turn comes round again
+        }
+    }
+
+    if (stream->output == NULL) {
+        emit_sequence_ids(sequence, completed);
+    } else {
+        ring_close(stream->output);
+    }
+    free(queues.next_burst);
+    free(queues.ready_time);
+    free(queues.key);
+    free(queues.wake);
+    free(queues.wheel_next);
+    free(queues.predicted);
+    free(queues.ready.items);
+    bitmap_free(&queues.ready_rows);
+    free(pids.slots);
+    free(pids.states);
+    free(sequence);
+}
+
+// One specialised engine per policy
+#define MULTIBURST_ENGINE(name, policy) \
+    void simulate_multiburst_##name(Row_Stream *stream, int quantum, float alpha, int io_time) { \
+        multiburst_loop(stream, policy, quantum, alpha, io_time); \
+    }
+
+MULTIBURST_ENGINE(fcfs, POLICY_FCFS)
+MULTIBURST_ENGINE(sjf, POLICY_SJF)
+MULTIBURST_ENGINE(priority, POLICY_PRIORITY)
+MULTIBURST_ENGINE(rr, POLICY_RR)
+MULTIBURST_ENGINE(srt, POLICY_SRT)
+MULTIBURST_ENGINE(edf, POLICY_EDF)
+
+// Function to run the specialised engine for policy over a stream, choosing it once
+void simulate_multiburst_stream(Row_Stream *stream, Policy policy, int quantum, float alpha, int io_time) {
+    switch (policy) {
+    case POLICY_FCFS: simulate_multiburst_fcfs(stream, quantum, alpha, io_time); break;
+    case POLICY_SJF: simulate_multiburst_sjf(stream, quantum, alpha, io_time); break;
+    case POLICY_PRIORITY: simulate_multiburst_priority(stream, quantum, alpha, io_time); break;
+    case POLICY_RR: simulate_multiburst_rr(stream, quantum, alpha, io_time); break;
+    case POLICY_SRT: simulate_multiburst_srt(stream, quantum, alpha, io_time); break;
+    case POLICY_EDF: simulate_multiburst_edf(stream, quantum, alpha, io_time); break;
+    }
+}
+
+// Function to simulate sorted rows of multi-burst processes in place
+void simulate_multiburst(Process_For_Sim rows[], int n, Policy policy, int quantum, float alpha, int io_time) {
+    Row_Stream stream = {.rows = rows, .capacity = n, .total = n};
+    simulate_multiburst_stream(&stream, policy, quantum, alpha, io_time);
+}
+
+// Function to check an algorithm and its parameter for the multi-burst engine, run for the
+// given option; prints the error and returns false if they do not fit
+bool parse_multiburst_algorithm(const char *algorithm, const char *parameter_text, const char *option,
+                                Policy *policy, int *quantum, float *alpha) {
+    if (!policy_from_name(algorithm, policy)) {
+        // The classic-only algorithms have no policy in the engine
+        bool classic_only = strcmp(algorithm, "MLFQ") == 0 || strcmp(algorithm, "CFS") == 0 ||
+                            strcmp(algorithm, "PriorityAging") == 0 || strcmp(algorithm, "Stride") == 0 ||
+                            strcmp(algorithm, "Lottery") == 0 || strcmp(algorithm, "EDF-NP") == 0;
+        if (classic_only) {
+            printf("Error: %s can not be run with %s.\n", algorithm, option);
+        } else {
+            printf("Error: Unsupported scheduling algorithm '%s'.\n", algorithm);
+        }
+        return false;
+    }
+    bool needs_parameter = (*policy == POLICY_RR || *policy == POLICY_SRT);
+    if (needs_parameter != (parameter_text != NULL)) {
+        printf("Error: No scheduling algorithm specified.\n");
+        return false;
+    }
+    *quantum = (*policy == POLICY_RR) ? atoi(parameter_text) : 0;
+    *alpha = (*policy == POLICY_SRT) ? (float)atof(parameter_text) : 0;
+    if (*policy == POLICY_RR && *quantum < 1) {
+        printf("Error: RR needs a positive quantum.\n");
+        return false;
+    }
+    return true;
+}
+
+// Function to run an algorithm over multi-burst processes with the given I/O time
+int run_multiburst(const char *algorithm, const char *parameter_text, int io_time) {
+    Policy policy;
+    int quantum;
+    float alpha;
+    if (!parse_multiburst_algorithm(algorithm, parameter_text, "--io", &policy, &quantum, &alpha)) {
+        return 1;
+    }
+
+    int n = 0;
+    Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+    // Simulate the bursts with I/O between them
+    simulate_multiburst(processes, n, policy, quantum, alpha, io_time);
+
+    // Display results and calculate average wait, turnaround, and response times
+    if (policy == POLICY_EDF) {
+        display_sim_rows(processes, n, -1);
+        display_deadline_statistics(processes, n);
+    } else {
+        display_sim_rows(processes, n, response_sentinel(algorithm));
+    }
+
+    // Context switches, idle time, CPU utilization and throughput over the whole run
+    display_cpu_stats();
+
+    free(processes);
+    return 0;
+}
+
+// Functions for the SMP mode
+//
+// With --cores <n> FCFS, SJF, Priority, RR, SRT and EDF run on n identical
+// CPUs. Each row is one job, as in the classic simulators. With --runqueue
+// global (the default) every core shares one ready queue: an idle core takes
+// the best ready job, and SRT and EDF preempt the running job with the worst
+// key when a better one is ready. With --runqueue percore each core has its
+// own queue. A new job goes to the lowest idle core, or else to the shortest
+// queue, and a preempted or expired job goes back on its own core's queue. A
+// core with nothing queued steals the last job of the longest queue. At the
+// first event of every --balance period jobs move from the longest queue to
+// the shortest until no two differ by more than one. SRT and EDF only preempt
+// the job running on the core a ready job was queued on.
+//
+// Queues are heaps with the multi-burst engine's keys, except that RR keys on
+// an enqueue counter, so every queue is first in, first out. The next core
+// event (the end of a slice or of a switch) comes from a tournament tree over
+// the cores, so finding it costs O(log cores). Placing, stealing and
+// preempting scan the cores. A job migrates when it runs on a different core
+// from the one it last ran on. With one core both queue modes give the same
+// schedule as --io 0 on a trace with one row per pid, except for RR.
+
+// One simulated CPU
+typedef struct {
+    int running;            // Row running or being switched to (-1 = idle)
+    bool switching;         // Still paying the switch cost before the row runs
+    int slice_start;        // Start of the part of the running row's slice not yet accounted for
+    int last_dispatched;    // Row that ran last, for the switch cost (-1 = none yet)
+    Index_Heap queue;       // Per-core run queue
+    int queue_capacity;     // Room in queue.items
+    bool dirty;             // Queue got a row since the last scheduling pass
+    long long busy;         // Time spent running rows
+    long long switches;     // Dispatches of a different row than the last one
+    long long migrations;   // Dispatches of a row that last ran on another core
+    long long steals;       // Rows taken from another core's queue
+} Smp_Core;
+
+// Tournament tree giving the core with the earliest event (ties to the lower core)
+typedef struct {
+    int size;               // Leaves, a power of two no smaller than the core count
+    int *winner;            // Core with the earliest event under each node (-1 = none)
+    long long *time;        // Event time of each core (LLONG_MAX = idle)
+} Core_Tree;
+
+// State of one SMP simulation
+typedef struct {
+    Process_For_Sim *rows;
+    int n;
+    Policy policy;
+    int quantum;
+    int core_count;
+    bool per_core;          // Per-core run queues instead of one global queue
+    Smp_Core *cores;
+    Core_Tree events;
+    Index_Heap global;      // Global run queue
+    uint64_t *key;          // Ready-queue key of each row
+    float *predicted;       // SRT: predicted remaining time of each row
+    int *last_core;         // Core each row last ran on (-1 = not yet run)
+    uint64_t enqueued;      // RR: rows queued so far, the first in, first out key
+    Index_Bitmap idle;      // Idle cores
+    int idle_count;
+    long long queued;       // Rows waiting in any queue
+    bool ready_changed;     // Global queue got a row since the last scheduling pass
+    int *dirty;             // Cores whose queue got a row since the last pass
+    int dirty_count;
+    Pid_Table pids;         // SRT: burst prediction per pid
+    long long migrations;
+    long long steals;
+    long long balanced;     // Rows moved by periodic balancing
+} Smp_State;
+
+// Function to record a new event time for a core and replay its path to the root
+void core_tree_update(Core_Tree *tree, int core, long long time) {
+    tree->time[core] = time;
+    for (int node = (tree->size + core) / 2; node >= 1; node /= 2) {
+        int a = tree->winner[2 * node], b = tree->winner[2 * node + 1];
+        tree->winner[node] = (b != -1 && (a == -1 || tree->time[b] < tree->time[a])) ? b : a;
+    }
+}
+
+// Function to add a row to a heap that grows as needed
+void smp_heap_push(Index_Heap *heap, int *capacity, int index) {
+    if (heap->size == *capacity) {
+        *capacity = (*capacity == 0) ? 16 : 2 * *capacity;
+        heap->items = (int *)realloc(heap->items, *capacity * sizeof(int));
+        if (heap->items == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+    }
+    heap_push(heap, index);
+}
+
+// Function to queue a ready row, on core's queue in per-core mode
+void smp_make_ready(Smp_State *smp, int i, int time, int core) {
+    if (smp->policy == POLICY_RR) {
+        smp->key[i] = smp->enqueued++;
+    } else {
+        smp->key[i] = policy_ready_key(smp->policy, &smp->rows[i], (uint64_t)((long long)time - INT32_MIN), smp->predicted[i]);
+    }
+    if (smp->per_core) {
+        Smp_Core *target = &smp->cores[core];
+        smp_heap_push(&target->queue, &target->queue_capacity, i);
+        if (!target->dirty) {
+            target->dirty = true;
+            smp->dirty[smp->dirty_count++] = core;
+        }
+    } else {
+        heap_push(&smp->global, i);
+        smp->ready_changed = true;
+    }
+    smp->queued++;
+}
+
+// Function to start or continue the slice of the row on a core
+void smp_start_slice(Smp_State *smp, int c, int time) {
+    Smp_Core *core = &smp->cores[c];
+    int slice = smp->rows[core->running].remaining_time;
+    if (smp->policy == POLICY_RR && smp->quantum < slice) {
+        slice = smp->quantum;
+    }
+    core->switching = false;
+    core->slice_start = time;
+    core_tree_update(&smp->events, c, (long long)time + slice);
+}
+
+// Function to put a row on an idle core, paying for the switch first if it is a different row
+void smp_dispatch(Smp_State *smp, int c, int i, int time) {
+    Smp_Core *core = &smp->cores[c];
+    core->running = i;
+    bitmap_clear(&smp->idle, c);
+    smp->idle_count--;
+    smp->queued--;
+    if (smp->last_core[i] != -1 && smp->last_core[i] != c) {
+        core->migrations++;
+        smp->migrations++;
+    }
+    smp->last_core[i] = c;
+
+    int cost = 0;
+    if (i != core->last_dispatched) {
+        core->last_dispatched = i;
+        core->switches++;
+        cpu_stats.switches++;
+        cost = options.switch_cost;
+        if (smp->rows[i].start_time != -1) {
+            // Its working set was evicted while it waited, wherever it ran before
+            cpu_stats.refills++;
+            cost += options.cache_refill;
+        }
+        cpu_stats.overhead += cost;
+    }
+    if (cost > 0) {
+        core->switching = true;
+        core_tree_update(&smp->events, c, (long long)time + cost);
+    } else {
+        smp_start_slice(smp, c, time);
+    }
+}
+
+// Function to account for the running row's work on a core up to time
+void smp_settle(Smp_State *smp, int c, int time) {
+    Smp_Core *core = &smp->cores[c];
+    int elapsed = time - core->slice_start;
+    if (core->running == -1 || core->switching || elapsed <= 0) {
+        return;
+    }
+    run_sim_slice_on(&smp->rows[core->running], core->slice_start, elapsed, c);
+    core->busy += elapsed;
+    if (smp->policy == POLICY_SRT) {
+        smp->predicted[core->running] = srt_run_down(smp->predicted[core->running], elapsed);
+    }
+    core->slice_start = time;
+}
+
+// Function to take the running row off a core, leaving it idle
+void smp_stop(Smp_State *smp, int c) {
+    smp->cores[c].running = -1;
+    bitmap_set(&smp->idle, c);
+    smp->idle_count++;
+    core_tree_update(&smp->events, c, LLONG_MAX);
+}
+
+// Function to preempt a core's row, putting it back on a queue, if the given ready row should run instead
+bool smp_preempt(Smp_State *smp, int c, int candidate, int time) {
+    Smp_Core *core = &smp->cores[c];
+    const Index_Heap *queue = smp->per_core ? &core->queue : &smp->global;
+    if (core->running == -1 || core->switching) {
+        return false;
+    }
+    if (smp->policy == POLICY_SRT) {
+        // Its predicted remaining time has gone down while it ran
+        smp_settle(smp, c, time);
+        smp->key[core->running] = float_order_key(smp->predicted[core->running]);
+    }
+    if (!heap_less(queue, candidate, core->running)) {
+        return false;
+    }
+    smp_settle(smp, c, time);
+    int preempted = core->running;
+    smp_stop(smp, c);
+    smp_make_ready(smp, preempted, time, c);
+    return true;
+}
+
+// Function to find the core with the most queued rows (-1 if every queue is empty)
+int smp_longest_queue(const Smp_State *smp) {
+    int longest = -1;
+    for (int c = 0; c < smp->core_count; c++) {
+        if (smp->cores[c].queue.size > 0 && (longest == -1 || smp->cores[c].queue.size > smp->cores[longest].queue.size)) {
+            longest = c;
+        }
+    }
+    return longest;
+}
+
+// Function to move the last row of one core's queue to another's (the last
+// item of a heap is a leaf, so taking it keeps the heap in order)
+void smp_move_queued(Smp_State *smp, int from, int to) {
+    Smp_Core *source = &smp->cores[from], *target = &smp->cores[to];
+    int i = source->queue.items[--source->queue.size];
+    smp_heap_push(&target->queue, &target->queue_capacity, i);
+    if (!target->dirty) {
+        target->dirty = true;
+        smp->dirty[smp->dirty_count++] = to;
+    }
+}
+
+// Function to even out the per-core queues, longest into shortest
+void smp_balance(Smp_State *smp) {
+    while (true) {
+        int longest = 0, shortest = 0;
+        for (int c = 1; c < smp->core_count; c++) {
+            if (smp->cores[c].queue.size > smp->cores[longest].queue.size) longest = c;
+            if (smp->cores[c].queue.size < smp->cores[shortest].queue.size) shortest = c;
+        }
+        if (smp->cores[longest].queue.size - smp->cores[shortest].queue.size <= 1) {
+            return;
+        }
+        smp_move_queued(smp, longest, shortest);
+        smp->balanced++;
+    }
+}
+
+// Function to fill idle cores and carry out preemptions after the events at time
+void smp_schedule(Smp_State *smp, int time) {
+    bool preemptive = policy_preemptive(smp->policy);
+    if (!smp->per_core) {
+        // Idle cores take the best ready rows, lowest core first
+        while (smp->idle_count > 0 && smp->global.size > 0) {
+            smp_dispatch(smp, bitmap_find_from(&smp->idle, 0), heap_pop(&smp->global), time);
+        }
+        // Then better ready rows displace the worst running ones
+        while (preemptive && smp->ready_changed && smp->global.size > 0) {
+            int worst = -1;
+            for (int c = 0; c < smp->core_count; c++) {
+                Smp_Core *core = &smp->cores[c];
+                if (core->running == -1 || core->switching) continue;
+                if (smp->policy == POLICY_SRT) {
+                    smp_settle(smp, c, time);
+                    smp->key[core->running] = float_order_key(smp->predicted[core->running]);
+                }
+                if (worst == -1 || heap_less(&smp->global, smp->cores[worst].running, core->running)) worst = c;
+            }
+            if (worst == -1 || !smp_preempt(smp, worst, smp->global.items[0], time)) break;
+            smp_dispatch(smp, worst, heap_pop(&smp->global), time);
+        }
+        smp->ready_changed = false;
+        return;
+    }
+
+    // Cores whose queue got rows run the best of them, or let it preempt
+    for (int d = 0; d < smp->dirty_count; d++) {
+        int c = smp->dirty[d];
+        Smp_Core *core = &smp->cores[c];
+        core->dirty = false;
+        if (core->queue.size == 0) continue;
+        if (core->running == -1 || (preemptive && smp_preempt(smp, c, core->queue.items[0], time))) {
+            smp_dispatch(smp, c, heap_pop(&core->queue), time);
+        }
+    }
+    smp->dirty_count = 0;
+
+    // Idle cores run their own queue's best row, or steal from the longest queue
+    for (int c = (smp->queued > 0) ? bitmap_find_from(&smp->idle, 0) : -1; c != -1 && smp->queued > 0;
+         c = bitmap_find_from(&smp->idle, c + 1)) {
+        Smp_Core *core = &smp->cores[c];
+        if (core->queue.size > 0) {
+            smp_dispatch(smp, c, heap_pop(&core->queue), time);
+            continue;
+        }
+        Smp_Core *victim = &smp->cores[smp_longest_queue(smp)];
+        core->steals++;
+        smp->steals++;
+        smp_dispatch(smp, c, victim->queue.items[--victim->queue.size], time);
+    }
+}
+
+// Function to simulate sorted rows on cores CPUs with the given policy
+void simulate_smp(Smp_State *smp, Process_For_Sim rows[], int n, Policy policy, int quantum, float alpha,
+                  int core_count, bool per_core, int balance_period) {
+    memset(smp, 0, sizeof(*smp));
+    smp->rows = rows;
+    smp->n = n;
+    smp->policy = policy;
+    smp->quantum = quantum;
+    smp->core_count = core_count;
+    smp->per_core = per_core;
+    smp->cores = (Smp_Core *)calloc(core_count, sizeof(Smp_Core));
+    smp->key = (uint64_t *)malloc((n + 1) * sizeof(uint64_t));
+    smp->predicted = (float *)malloc((n + 1) * sizeof(float));
+    smp->last_core = (int *)malloc((n + 1) * sizeof(int));
+    smp->dirty = (int *)malloc(core_count * sizeof(int));
+    int *sequence = (int *)malloc((n + 1) * sizeof(int));
+    smp->events.size = 1;
+    while (smp->events.size < core_count) smp->events.size *= 2;
+    smp->events.winner = (int *)malloc(2 * smp->events.size * sizeof(int));
+    smp->events.time = (long long *)malloc(core_count * sizeof(long long));
+    if (smp->cores == NULL || smp->key == NULL || smp->predicted == NULL || smp->last_core == NULL ||
+        smp->dirty == NULL || sequence == NULL || smp->events.winner == NULL || smp->events.time == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    smp->global = heap_create(per_core ? 0 : n, smp->key);
+    smp->idle = bitmap_create(core_count);
+    for (int c = 0; c < core_count; c++) {
+        smp->cores[c].running = -1;
+        smp->cores[c].last_dispatched = -1;
+        smp->cores[c].queue.key = smp->key;
+        bitmap_set(&smp->idle, c);
+        smp->events.time[c] = LLONG_MAX;
+    }
+    smp->idle_count = core_count;
+    for (int node = 0; node < 2 * smp->events.size; node++) {
+        int core = node - smp->events.size;
+        smp->events.winner[node] = (core >= 0 && core < core_count) ? core : -1;
+    }
+    for (int node = smp->events.size - 1; node >= 1; node--) {
+        smp->events.winner[node] = (smp->events.winner[2 * node] != -1) ? smp->events.winner[2 * node] : smp->events.winner[2 * node + 1];
+    }
+    for (int i = 0; i < n; i++) {
+        smp->last_core[i] = -1;
+    }
+    cpu_stats.cores = core_count;
+
+    int arrived = 0, completed = 0;
+    long long next_balance = balance_period;
+    while (completed < n) {
+        // The next event: an arrival or the end of a slice or switch
+        long long next_event = (arrived < n) ? rows[arrived].arrival_time : LLONG_MAX;
+        int first = smp->events.winner[1];
+        if (first != -1 && smp->events.time[first] < next_event) next_event = smp->events.time[first];
+        if (next_event == LLONG_MAX) {
+            break;
+        }
+        int time = (int)next_event;
+
+        // Cores whose switch or slice ends now
+        int c;
+        while ((c = smp->events.winner[1]) != -1 && smp->events.time[c] == time) {
+            Smp_Core *core = &smp->cores[c];
+            if (core->switching) {
+                smp_start_slice(smp, c, time);
+                continue;
+            }
+            smp_settle(smp, c, time);
+            int i = core->running;
+            Process_For_Sim *row = &rows[i];
+            smp_stop(smp, c);
+            if (row->remaining_time > 0) {
+                smp_make_ready(smp, i, time, c);  // RR: the quantum ran out
+                continue;
+            }
+            if (row->start_time == -1) {
+                row->start_time = time;  // An empty burst
+            }
+            row->completion_time = time;
+            row->waiting_time = (time - row->arrival_time) - row->burst_time;
+            record_completion(row->arrival_time, row->burst_time, time);
+
+            // Response time as the matching classic simulator computes it
+            if (policy == POLICY_FCFS || policy == POLICY_SJF) {
+                row->response_time = row->start_time + row->time_until_first_response;
+            } else if (policy == POLICY_PRIORITY || policy == POLICY_SRT) {
+                row->response_time = row->waiting_time + row->time_until_first_response;
+            }
+            if (policy == POLICY_SRT) {
+                update_prediction(&pid_table_get(&smp->pids, row->process_id)->prediction, row->burst_time, alpha);
+            }
+            sequence[completed++] = row->process_id;
+        }
+
+        // Rows arriving now go to the global queue, an idle core or the shortest queue
+        for (; arrived < n && rows[arrived].arrival_time <= time; arrived++) {
+            if (policy == POLICY_SRT) {
+                smp->predicted[arrived] = pid_table_get(&smp->pids, rows[arrived].process_id)->prediction.tau;
+            }
+            int target = 0;
+            if (per_core) {
+                // The lowest idle core nothing is queued on yet, else the shortest queue
+                target = -1;
+                for (int k = bitmap_find_from(&smp->idle, 0); k != -1 && target == -1; k = bitmap_find_from(&smp->idle, k + 1)) {
+                    if (smp->cores[k].queue.size == 0) target = k;
+                }
+                if (target == -1) {
+                    target = 0;
+                    for (int k = 1; k < core_count; k++) {
+                        if (smp->cores[k].queue.size < smp->cores[target].queue.size) target = k;
+                    }
+                }
+            }
+            smp_make_ready(smp, arrived, time, target);
+        }
+
+        if (per_core && balance_period > 0 && time >= next_balance) {
+            smp_balance(smp);
+            next_balance = ((long long)time / balance_period + 1) * balance_period;
+        }
+        smp_schedule(smp, time);
+    }
+
+    emit_sequence_ids(sequence, completed);
+    free(sequence);
+}
+
+// Function to free what simulate_smp allocated
+void free_smp(Smp_State *smp) {
+    for (int c = 0; c < smp->core_count; c++) {
+        free(smp->cores[c].queue.items);
+    }
+    free(smp->cores);
+    free(smp->key);
+    free(smp->predicted);
+    free(smp->last_core);
+    free(smp->dirty);
+    free(smp->events.winner);
+    free(smp->events.time);
+    free(smp->global.items);
+    bitmap_free(&smp->idle);
+    free(smp->pids.slots);
+    free(smp->pids.states);
+}
+
+// Function to print each core's busy time, utilization, switches, migrations and steals
+void display_smp_cores(const Smp_State *smp) {
+    if (options.output != OUTPUT_TABLE) {
+        return;  // The structured formats carry the totals in their summary
+    }
+    long long span = (cpu_stats.jobs > 0) ? (long long)cpu_stats.last_finish - cpu_stats.first_arrival : 0;
+    printf("\nMigrations: %lld\n", smp->migrations);
+    if (smp->per_core) {
+        printf("Steals: %lld\n", smp->steals);
+        printf("Balancing Moves: %lld\n", smp->balanced);
+    }
+    if (options.quiet) {
+        return;
+    }
+    printf("+------+------------+-------------+----------+------------+----------+\n");
+    printf("| Core | Busy Time  | Utilization | Switches | Migrations | Steals   |\n");
+    printf("+------+------------+-------------+----------+------------+----------+\n");
+    for (int c = 0; c < smp->core_count; c++) {
+        const Smp_Core *core = &smp->cores[c];
+        printf("| %4d | %10lld | %10.2f%% | %8lld | %10lld | %8lld |\n", c, core->busy,
+               (span > 0) ? 100.0 * core->busy / span : 0.0, core->switches, core->migrations, core->steals);
+    }
+    printf("+------+------------+-------------+----------+------------+----------+\n");
+}
+
+// Function to run an algorithm over the trace on stdin on --cores CPUs
+int run_smp(const char *algorithm, const char *parameter_text) {
+    Policy policy;
+    int quantum;
+    float alpha;
+    if (!parse_multiburst_algorithm(algorithm, parameter_text, "--cores", &policy, &quantum, &alpha)) {
+        return 1;
+    }
+
+    int n = 0;
+    Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+    // Simulate the jobs on the cores
+    Smp_State smp;
+    simulate_smp(&smp, processes, n, policy, quantum, alpha, options.cores, options.per_core_queues, options.balance_period);
+
+    // Display results and calculate average wait, turnaround, and response times
+    if (policy == POLICY_EDF) {
+        display_sim_rows(processes, n, -1);
+        display_deadline_statistics(processes, n);
+    } else {
+        display_sim_rows(processes, n, response_sentinel(algorithm));
+    }
+
+    // Context switches, idle time and utilization over all cores, then each core
+    display_cpu_stats();
+    display_smp_cores(&smp);
+
+    free_smp(&smp);
+    free(processes);
+    return 0;
+}
+
+// Functions for the pipelined mode
+//
+// With --pipeline the multi-burst engine runs on three threads. A reader
+// thread parses stdin and pushes rows into one ring. The engine, on the main
+// thread, takes rows only as simulated time reaches their arrival. It pushes
+// each completed row into a second ring. A writer thread formats the sequence
+// as completions come in, folds them into the per-pid table, and prints the
+// table at the end. Parsing, simulating and printing overlap, so a large
+// trace takes about as long as its slowest stage. The trace has to be in
+// arrival order already. Rows with the same arrival are held back until the
+// next arrival time shows up, then sorted by pid like read_trace_from_stdin
+// does.
+
+typedef struct {
+    FILE *input;
+    Spsc_Ring *rows;
+} Pipeline_Reader;
+
+typedef struct {
+    Spsc_Ring *completions;
+    int sentinel;
+    Pid_Summary *pids;      // The table, left for the main thread to print
+    int pid_count;
+    int last_pid;
+    int rows;
+} Pipeline_Writer;
+
+// Function run by the reader thread: parse the trace into the row ring
+void *pipeline_read(void *argument) {
+    Pipeline_Reader *reader = (Pipeline_Reader *)argument;
+    char buffer[BUFFER_SIZE];
+    int group_count = 0, group_capacity = 256, index = 0;
+    Process_For_Sim *group = (Process_For_Sim *)malloc(group_capacity * sizeof(Process_For_Sim));
+    if (group == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    fgets(buffer, sizeof(buffer), reader->input);  // Skip the first line (header)
+    while (true) {
+        Process_For_Sim row;
+        bool more = fgets(buffer, sizeof(buffer), reader->input) != NULL;
+        if (more && !parse_sim_row(buffer, &row)) {
+            continue;
+        }
+
+        // A new arrival time completes the group of rows arriving together
+        if (group_count > 0 && (!more || row.arrival_time != group[0].arrival_time)) {
+            if (more && row.arrival_time < group[0].arrival_time) {
+                printf("Error: --pipeline needs the trace in arrival order (pid %d arrives at %d after time %d).\n",
+                       row.process_id, row.arrival_time, group[0].arrival_time);
+                exit(1);
+            }
+            qsort(group, group_count, sizeof(Process_For_Sim), compare_sim_rows);
+            for (int i = 0; i < group_count; i++) {
+                ring_push(reader->rows, &group[i]);
+            }
+            group_count = 0;
+        }
+        if (!more) {
+            break;
+        }
+
+        row.input_index = index++;
+        row.remaining_time = row.burst_time;
+        row.start_time = -1;
+        row.completion_time = -1;
+        row.response_time = -1;
+        if (group_count == group_capacity) {
+            group_capacity *= 2;
+            group = (Process_For_Sim *)realloc(group, group_capacity * sizeof(Process_For_Sim));
+            if (group == NULL) {
+                printf("Memory allocation failed\n");
+                exit(1);
+            }
+        }
+        group[group_count++] = row;
+    }
+
+    ring_close(reader->rows);
+    free(group);
+    return NULL;
+}
+
+// Function run by the writer thread: print the sequence as rows complete and build the table
+// (printed by the main thread, whose cpu_stats the summary formats need)
+void *pipeline_write(void *argument) {
+    Pipeline_Writer *writer = (Pipeline_Writer *)argument;
+    int pid_count = 0, last_pid = 50, n = 0;
+    Pid_Summary *pids = NULL;
+    char line[4096];
+    char *end = line;
+
+    if (sequence_output_enabled) {
+        end = format_text(end, "seq = [");
+    }
+    Process_For_Sim row;
+    while (ring_pop(writer->completions, &row)) {
+        if (sequence_output_enabled) {
+            if (end - line > (long)sizeof(line) - 16) {
+                fwrite(line, 1, end - line, stdout);
+                end = line;
+            }
+            if (n > 0) *end++ = ',';
+            end = format_decimal(end, row.process_id);
+        }
+        if (row.process_id >= 0) {
+            pids = grow_pid_summaries(pids, &pid_count, row.process_id, writer->sentinel);
+            add_to_pid_summary(&pids[row.process_id], &row, writer->sentinel);
+            if (row.process_id > last_pid) last_pid = row.process_id;
+        }
+        n++;
+    }
+    if (sequence_output_enabled) {
+        end = format_text(end, "]\n");
+        fwrite(line, 1, end - line, stdout);
+    }
+
+    writer->pids = pids;
+    writer->pid_count = pid_count;
+    writer->last_pid = last_pid;
+    writer->rows = n;
+    return NULL;
+}
+
+// Function to run an algorithm over multi-burst processes with parsing, simulation
+// and output on separate threads
+int run_pipelined(const char *algorithm, const char *parameter_text, int io_time) {
+    Policy policy;
+    int quantum;
+    float alpha;
+    if (!parse_multiburst_algorithm(algorithm, parameter_text, "--pipeline", &policy, &quantum, &alpha)) {
+        return 1;
+    }
+
+    Spsc_Ring rows, completions;
+    ring_init(&rows, sizeof(Process_For_Sim));
+    ring_init(&completions, sizeof(Process_For_Sim));
+    Pipeline_Reader reader = {stdin, &rows};
+    Pipeline_Writer writer = {&completions, (policy == POLICY_EDF) ? -1 : response_sentinel(algorithm), NULL, 0, 0, 0};
+
+    pthread_t reader_thread, writer_thread;
+    if (pthread_create(&reader_thread, NULL, pipeline_read, &reader) != 0 ||
+        pthread_create(&writer_thread, NULL, pipeline_write, &writer) != 0) {
+        printf("Error: Could not start the pipeline threads.\n");
+        return 1;
+    }
+
+    // Simulate on this thread as rows come in
+    Row_Stream stream = {.input = &rows, .output = &completions};
+    simulate_multiburst_stream(&stream, policy, quantum, alpha, io_time);
+
+    pthread_join(reader_thread, NULL);
+    pthread_join(writer_thread, NULL);
+
+    display_pid_summaries(writer.pids, writer.pid_count, writer.last_pid, writer.rows, writer.sentinel);
+    free(writer.pids);
+    if (policy == POLICY_EDF) {
+        display_deadline_statistics(stream.rows, stream.count);
+    }
+
+    // Context switches, idle time, CPU utilization and throughput over the whole run
+    display_cpu_stats();
+
+    free(stream.rows);
+    free(rows.items);
+    free(completions.items);
+    return 0;
+}
+
+// Functions for the server mode
+//
+// With --serve <socket> the program stays resident and answers simulation
+// requests on a Unix domain socket. A caller that runs many small what-if
+// traces then pays neither process start-up nor option parsing each time.
+// The main thread accepts connections and queues them for --workers threads
+// (default 4). A connection carries one request: header lines, a blank line,
+// then CSV rows until the client shuts down its side for writing.
+//
+//     algorithm <name> [<parameter>]   required, as on the command line
+//     io <ticks>                       optional: the multi-burst engine, as with --io
+//     trace <id>                       start from a stored trace and append the body rows to it
+//     store <id>                       keep the resulting trace under id for later requests
+//     format json|bin                  response format (default json)
+//
+// Body lines that are not rows, such as a CSV header, are skipped as usual.
+// Stored traces stay parsed in memory, up to SERVER_TRACE_SLOTS of them, and
+// the least recently used one is dropped first. Other options (--quanta,
+// --latency, --seed, --cs-cost, ...) are taken from the server's command line.
+
+#define SERVER_TRACE_SLOTS 64
+#define SERVER_QUEUE_SIZE 64
+#define SERVER_MAX_REQUEST (64 << 20)  // Bytes
+#define SERVER_ID_SIZE 64
+#define RESPONSE_MAGIC "SCHEDRS1"
+
+// Growable byte buffer for requests and responses
+typedef struct {
+    char *data;
+    size_t used;
+    size_t capacity;
+} Byte_Buffer;
+
+// Function to append length bytes to a buffer
+void buffer_append(Byte_Buffer *buffer, const void *data, size_t length) {
+    if (buffer->used + length > buffer->capacity) {
+        size_t capacity = (buffer->capacity == 0) ? 4096 : buffer->capacity;
+        while (capacity < buffer->used + length) capacity *= 2;
+        buffer->data = (char *)realloc(buffer->data, capacity);
+        if (buffer->data == NULL) {
+            printf("Memory allocation failed\n");
+            exit(1);
+        }
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->used, data, length);
+    buffer->used += length;
+}
+
+// Function to append a string to a buffer
+void buffer_append_text(Byte_Buffer *buffer, const char *text) {
+    buffer_append(buffer, text, strlen(text));
+}
+
+// Function to append an integer in decimal to a buffer
+void buffer_append_decimal(Byte_Buffer *buffer, long long value) {
+    char digits[24];
+    buffer_append(buffer, digits, format_decimal(digits, value) - digits);
+}
+
+// A trace kept between requests, in input order
+typedef struct {
+    char id[SERVER_ID_SIZE];     // Empty if the slot is free
+    Process_For_Sim *rows;
+    int count;
+    unsigned long long last_used;
+} Cached_Trace;
+
+Cached_Trace trace_cache[SERVER_TRACE_SLOTS];
+unsigned long long trace_cache_clock = 0;
+pthread_mutex_t trace_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Function to copy a stored trace into rows (grown as needed); returns false if id is unknown
+bool trace_cache_load(const char *id, Process_For_Sim **rows, int *count, int *capacity) {
+    bool found = false;
+    pthread_mutex_lock(&trace_cache_lock);
+    for (int i = 0; i < SERVER_TRACE_SLOTS; i++) {
+        Cached_Trace *entry = &trace_cache[i];
+        if (entry->id[0] != '\0' && strcmp(entry->id, id) == 0) {
+            if (entry->count > *capacity) {
+                *capacity = entry->count;
+                *rows = (Process_For_Sim *)realloc(*rows, *capacity * sizeof(Process_For_Sim));
+                if (*rows == NULL) {
+                    printf("Memory allocation failed\n");
+                    exit(1);
+                }
+            }
+            memcpy(*rows, entry->rows, entry->count * sizeof(Process_For_Sim));
+            *count = entry->count;
+            entry->last_used = ++trace_cache_clock;
+            found = true;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&trace_cache_lock);
+    return found;
+}
+
+// Function to store a copy of a trace under id, replacing the trace with that id or the least recently used one
+void trace_cache_store(const char *id, const Process_For_Sim rows[], int count) {
+    Process_For_Sim *copy = (Process_For_Sim *)malloc((count + 1) * sizeof(Process_For_Sim));
+    if (copy == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    memcpy(copy, rows, count * sizeof(Process_For_Sim));
+
+    pthread_mutex_lock(&trace_cache_lock);
+    int slot = 0;
+    for (int i = 0; i < SERVER_TRACE_SLOTS; i++) {
+        if (trace_cache[i].id[0] != '\0' && strcmp(trace_cache[i].id, id) == 0) {
+            slot = i;
+            break;
+        }
+        if (trace_cache[i].last_used < trace_cache[slot].last_used) {
+            slot = i;  // Free slots have last_used 0, so they go first
+        }
+    }
+    free(trace_cache[slot].rows);
+    snprintf(trace_cache[slot].id, SERVER_ID_SIZE, "%s", id);
+    trace_cache[slot].rows = copy;
+    trace_cache[slot].count = count;
+    trace_cache[slot].last_used = ++trace_cache_clock;
+    pthread_mutex_unlock(&trace_cache_lock);
+}
+
+// Function to tell whether an algorithm takes a parameter on the command line
+bool algorithm_needs_parameter(const char *algorithm) {
+    return strcmp(algorithm, "RR") == 0 || strcmp(algorithm, "SRT") == 0 || strcmp(algorithm, "MLFQ") == 0 ||
+           strcmp(algorithm, "CFS") == 0 || strcmp(algorithm, "PriorityAging") == 0 ||
+           strcmp(algorithm, "Stride") == 0 || strcmp(algorithm, "Lottery") == 0;
+}
+
+// Function to run any algorithm over sorted rows without printing anything;
+// returns false with a message in error if the algorithm or its parameter is not valid
+bool simulate_algorithm_rows(const char *algorithm, const char *parameter_text, int io_time,
+                             Process_For_Sim rows[], int n, char *error, size_t size) {
+    bool has_parameter = (parameter_text != NULL);
+    int parameter = has_parameter ? atoi(parameter_text) : 0;
+    float real_parameter = has_parameter ? (float)atof(parameter_text) : 0;
+    bool needs_parameter = algorithm_needs_parameter(algorithm);
+    if (needs_parameter != has_parameter) {
+        snprintf(error, size, "%s %s a parameter", algorithm, needs_parameter ? "needs" : "does not take");
+        return false;
+    }
+    bool quantum_parameter = strcmp(algorithm, "RR") == 0 || strcmp(algorithm, "CFS") == 0 ||
+                             strcmp(algorithm, "Stride") == 0 || strcmp(algorithm, "Lottery") == 0;
+    if (quantum_parameter && parameter < 1) {
+        snprintf(error, size, "%s needs a positive parameter", algorithm);
+        return false;
+    }
+
+    Policy policy;
+    if (io_time >= 0) {
+        if (!policy_from_name(algorithm, &policy)) {
+            snprintf(error, size, "%s can not be run with io", algorithm);
+            return false;
+        }
+        simulate_multiburst(rows, n, policy, parameter, real_parameter, io_time);
+    } else if (response_sentinel(algorithm) != -2) {
+        simulate_sim_rows(algorithm, real_parameter, rows, n, 0, NULL, 0);
+    } else if (strcmp(algorithm, "MLFQ") == 0) {
+        if (parameter < 1 || parameter > MLFQ_MAX_LEVELS) {
+            snprintf(error, size, "MLFQ needs between 1 and %d levels", MLFQ_MAX_LEVELS);
+            return false;
+        }
+        int quanta[MLFQ_MAX_LEVELS];
+        if (!fill_mlfq_quanta(options.quanta, quanta, parameter)) {
+            snprintf(error, size, "MLFQ quanta must be positive");
+            return false;
+        }
+        simulateMLFQ(rows, n, parameter, quanta, options.boost_period);
+    } else if (strcmp(algorithm, "CFS") == 0) {
+        simulateCFS(rows, n, parameter, options.latency);
+    } else if (strcmp(algorithm, "PriorityAging") == 0) {
+        if (!simulate_priority_aging(rows, n, parameter)) {
+            snprintf(error, size, "PriorityAging priorities (or pids, without a fifth column) must span fewer than %d levels", AGING_MAX_LEVELS);
+            return false;
+        }
+    } else if (strcmp(algorithm, "Stride") == 0) {
+        simulate_stride(rows, n, parameter);
+    } else if (strcmp(algorithm, "Lottery") == 0) {
+        simulate_lottery(rows, n, parameter, options.seed);
+    } else if (strcmp(algorithm, "EDF") == 0 || strcmp(algorithm, "EDF-NP") == 0) {
+        simulate_edf(rows, n, strcmp(algorithm, "EDF") == 0);
+    } else {
+        snprintf(error, size, "unsupported scheduling algorithm '%s'", algorithm);
+        return false;
+    }
+    return true;
+}
+
+// Function to build the response for simulated rows: the table's numbers per row,
+// the completion sequence, the averages as the table prints them and the CPU figures
+void build_response(Byte_Buffer *response, bool binary, const Process_For_Sim rows[], int n, int sentinel) {
+    // Averages exactly as the table shows them
+    double averages[3];
+    average_sim_rows(rows, n, sentinel, averages);
+
+    Completion_Entry *order = (Completion_Entry *)malloc((n + 1) * sizeof(Completion_Entry));
+    if (order == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int i = 0; i < n; i++) {
+        order[i].completion_time = rows[i].completion_time;
+        order[i].index = i;
+    }
+    qsort(order, n, sizeof(Completion_Entry), compare_completions);
+
+    long long span = (cpu_stats.jobs > 0) ? (long long)cpu_stats.last_finish - cpu_stats.first_arrival : 0;
+    double utilization = (span > 0) ? 100.0 * cpu_stats.busy / span : 0;
+
+    if (binary) {
+        int32_t header[2] = {0, n};
+        buffer_append(response, RESPONSE_MAGIC, strlen(RESPONSE_MAGIC));
+        buffer_append(response, header, sizeof(header));
+        for (int i = 0; i < n; i++) {
+            const Process_For_Sim *row = &rows[i];
+            int32_t values[7] = {row->process_id, row->arrival_time, row->burst_time, row->start_time,
+                                 row->completion_time, row->waiting_time, row->response_time - row->arrival_time};
+            buffer_append(response, values, sizeof(values));
+        }
+        for (int i = 0; i < n; i++) {
+            int32_t pid = rows[order[i].index].process_id;
+            buffer_append(response, &pid, sizeof(pid));
+        }
+        int64_t switches = cpu_stats.switches;
+        buffer_append(response, averages, sizeof(averages));
+        buffer_append(response, &switches, sizeof(switches));
+        buffer_append(response, &utilization, sizeof(utilization));
+    } else {
+        char number[64];
+        buffer_append_text(response, "{\"rows\":");
+        buffer_append_decimal(response, n);
+        buffer_append_text(response, ",\"sequence\":[");
+        for (int i = 0; i < n; i++) {
+            if (i > 0) buffer_append_text(response, ",");
+            buffer_append_decimal(response, rows[order[i].index].process_id);
+        }
+        buffer_append_text(response, "],\"processes\":[");
+        for (int i = 0; i < n; i++) {
+            const Process_For_Sim *row = &rows[i];
+            buffer_append_text(response, (i > 0) ? ",{\"pid\":" : "{\"pid\":");
+            buffer_append_decimal(response, row->process_id);
+            buffer_append_text(response, ",\"arrival\":");
+            buffer_append_decimal(response, row->arrival_time);
+            buffer_append_text(response, ",\"burst\":");
+            buffer_append_decimal(response, row->burst_time);
+            buffer_append_text(response, ",\"start\":");
+            buffer_append_decimal(response, row->start_time);
+            buffer_append_text(response, ",\"finish\":");
+            buffer_append_decimal(response, row->completion_time);
+            buffer_append_text(response, ",\"wait\":");
+            buffer_append_decimal(response, row->waiting_time);
+            buffer_append_text(response, ",\"turnaround\":");
+            buffer_append_decimal(response, (long long)row->completion_time - row->arrival_time);
+            buffer_append_text(response, ",\"response\":");
+            buffer_append_decimal(response, (long long)row->response_time - row->arrival_time);
+            buffer_append_text(response, "}");
+        }
+        snprintf(number, sizeof(number), "],\"average_waiting\":%.2f", averages[0]);
+        buffer_append_text(response, number);
+        snprintf(number, sizeof(number), ",\"average_turnaround\":%.2f", averages[1]);
+        buffer_append_text(response, number);
+        snprintf(number, sizeof(number), ",\"average_response\":%.2f", averages[2]);
+        buffer_append_text(response, number);
+        buffer_append_text(response, ",\"context_switches\":");
+        buffer_append_decimal(response, cpu_stats.switches);
+        snprintf(number, sizeof(number), ",\"cpu_utilization\":%.2f}\n", utilization);
+        buffer_append_text(response, number);
+    }
+    free(order);
+}
+
+// Function to build an error response
+void build_error_response(Byte_Buffer *response, bool binary, const char *message) {
+    if (binary) {
+        int32_t header[2] = {1, (int32_t)strlen(message)};
+        buffer_append(response, RESPONSE_MAGIC, strlen(RESPONSE_MAGIC));
+        buffer_append(response, header, sizeof(header));
+        buffer_append_text(response, message);
+        return;
+    }
+    buffer_append_text(response, "{\"error\":\"");
+    for (const char *c = message; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') buffer_append_text(response, "\\");
+        buffer_append(response, c, 1);
+    }
+    buffer_append_text(response, "\"}\n");
+}
+
+// Function to answer one request held in request (NUL-terminated at length); the response goes into response
+void handle_request(char *request, size_t length, Byte_Buffer *response) {
+    const char *algorithm = NULL, *parameter_text = NULL, *base = NULL, *store = NULL;
+    bool binary = false;
+    int io_time = -1;
+    char error[160] = "";
+    char *end = request + length;
+
+    // Header lines up to the first empty line, each cut out of the buffer in place
+    char *cursor = request;
+    while (cursor < end) {
+        char *line = cursor;
+        char *newline = memchr(cursor, '\n', end - cursor);
+        cursor = (newline != NULL) ? newline + 1 : end;
+        if (newline != NULL) *newline = '\0';
+        if (newline != NULL && newline > line && newline[-1] == '\r') newline[-1] = '\0';
+        if (line[0] == '\0') {
+            break;
+        }
+
+        char *save;
+        char *key = strtok_r(line, " \t", &save);
+        char *value = strtok_r(NULL, " \t", &save);
+        char *extra = strtok_r(NULL, " \t", &save);
+        if (key == NULL || value == NULL) {
+            snprintf(error, sizeof(error), "incomplete header line");
+        } else if (strcmp(key, "algorithm") == 0) {
+            algorithm = value;
+            parameter_text = extra;
+            extra = NULL;
+        } else if (strcmp(key, "io") == 0) {
+            io_time = atoi(value);
+            if (io_time < 0) snprintf(error, sizeof(error), "io must not be negative");
+        } else if (strcmp(key, "trace") == 0) {
+            base = value;
+        } else if (strcmp(key, "store") == 0) {
+            store = value;
+        } else if (strcmp(key, "format") == 0) {
+            if (strcmp(value, "bin") == 0) binary = true;
+            else if (strcmp(value, "json") != 0) snprintf(error, sizeof(error), "unknown format '%s'", value);
+        } else {
+            snprintf(error, sizeof(error), "unknown header '%s'", key);
+        }
+        if (error[0] == '\0' && extra != NULL) {
+            snprintf(error, sizeof(error), "too many values for '%s'", key);
+        }
+        if (error[0] == '\0' && strlen(value) >= SERVER_ID_SIZE) {
+            snprintf(error, sizeof(error), "'%s' value too long", key);
+        }
+        if (error[0] != '\0') {
+            build_error_response(response, binary, error);
+            return;
+        }
+    }
+    if (algorithm == NULL) {
+        build_error_response(response, binary, "no scheduling algorithm specified");
+        return;
+    }
+
+    // The stored trace, if any, followed by the rows of the body in input order
+    int n = 0, capacity = 1024;
+    Process_For_Sim *rows = (Process_For_Sim *)malloc(capacity * sizeof(Process_For_Sim));
+    if (rows == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    if (base != NULL && !trace_cache_load(base, &rows, &n, &capacity)) {
+        snprintf(error, sizeof(error), "no stored trace '%s'", base);
+        build_error_response(response, binary, error);
+        free(rows);
+        return;
+    }
+    while (cursor < end) {
+        char *line = cursor;
+        char *newline = memchr(cursor, '\n', end - cursor);
+        cursor = (newline != NULL) ? newline + 1 : end;
+        if (newline != NULL) *newline = '\0';
+
+        Process_For_Sim row;
+        if (!parse_sim_row(line, &row)) {
+            continue;
+        }
+        row.input_index = n;
+        if (n == capacity) {
+            capacity *= 2;
+            rows = (Process_For_Sim *)realloc(rows, capacity * sizeof(Process_For_Sim));
+            if (rows == NULL) {
+                printf("Memory allocation failed\n");
+                exit(1);
+            }
+        }
+        rows[n++] = row;
+    }
+    if (store != NULL) {
+        trace_cache_store(store, rows, n);
+    }
+    if (n == 0) {
+        build_error_response(response, binary, "no rows");
+        free(rows);
+        return;
+    }
+
+    // Simulate with this thread's counters starting from zero
+    Cpu_Stats fresh = {.last_dispatched = -1};
+    cpu_stats = fresh;
+    prepare_sim_rows(rows, n);
+    if (!simulate_algorithm_rows(algorithm, parameter_text, io_time, rows, n, error, sizeof(error))) {
+        build_error_response(response, binary, error);
+    } else {
+        int sentinel = response_sentinel(algorithm);
+        build_response(response, binary, rows, n, (sentinel == -2) ? -1 : sentinel);
+    }
+    free(rows);
+}
+
+// Connections accepted but not yet taken by a worker
+typedef struct {
+    int sockets[SERVER_QUEUE_SIZE];
+    int head;
+    int count;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;   // Signalled when a connection is queued
+    pthread_cond_t space;   // Signalled when a worker takes one
+} Connection_Queue;
+
+Connection_Queue connections = {.lock = PTHREAD_MUTEX_INITIALIZER, .ready = PTHREAD_COND_INITIALIZER,
+                                .space = PTHREAD_COND_INITIALIZER};
+
+// Set by SIGINT or SIGTERM to stop accepting connections
+volatile sig_atomic_t server_stopping = 0;
+
+void stop_server(int signal_number) {
+    (void)signal_number;
+    server_stopping = 1;
+}
+
+// Function to write all of a buffer to a socket; false if the client went away
+bool write_fully(int socket, const char *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(socket, data, length);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        length -= (size_t)written;
+    }
+    return true;
+}
+
+// Function run by each worker thread: read a request, answer it, close the connection
+void *serve_connections(void *argument) {
+    (void)argument;
+    Byte_Buffer request = {NULL, 0, 0}, response = {NULL, 0, 0};
+    for (;;) {
+        pthread_mutex_lock(&connections.lock);
+        while (connections.count == 0) {
+            pthread_cond_wait(&connections.ready, &connections.lock);
+        }
+        int client = connections.sockets[connections.head];
+        connections.head = (connections.head + 1) % SERVER_QUEUE_SIZE;
+        connections.count--;
+        pthread_cond_signal(&connections.space);
+        pthread_mutex_unlock(&connections.lock);
+
+        // The request ends when the client shuts down its side
+        request.used = 0;
+        response.used = 0;
+        char chunk[BUFFER_SIZE * 16];
+        ssize_t received;
+        bool too_large = false;
+        while ((received = read(client, chunk, sizeof(chunk))) != 0) {
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+            if (request.used + (size_t)received > SERVER_MAX_REQUEST) {
+                too_large = true;
+                break;
+            }
+            buffer_append(&request, chunk, (size_t)received);
+        }
+        buffer_append(&request, "", 1);  // NUL terminator for the last line
+
+        if (too_large) {
+            build_error_response(&response, false, "request too large");
+        } else {
+            handle_request(request.data, request.used - 1, &response);
+        }
+        write_fully(client, response.data, response.used);
+        close(client);
+    }
+    return NULL;
+}
+
+// Function to listen on a Unix socket at path and answer requests with workers threads until stopped
+int run_server(const char *path, int workers) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        printf("Error: Socket path '%s' is too long.\n", path);
+        return 1;
+    }
+    strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path);  // A socket left behind by an earlier server
+    if (listener < 0 || bind(listener, (struct sockaddr *)&address, sizeof(address)) != 0 ||
+        listen(listener, SERVER_QUEUE_SIZE) != 0) {
+        printf("Error: Could not listen on '%s'.\n", path);
+        return 1;
+    }
+
+    // Clients that hang up early must not kill the server; a signal ends the accept loop
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction stop;
+    memset(&stop, 0, sizeof(stop));
+    stop.sa_handler = stop_server;
+    sigaction(SIGINT, &stop, NULL);
+    sigaction(SIGTERM, &stop, NULL);
+
+    for (int i = 0; i < workers; i++) {
+        pthread_t worker;
+        if (pthread_create(&worker, NULL, serve_connections, NULL) != 0) {
+            printf("Error: Could not start the worker threads.\n");
+            return 1;
+        }
+        pthread_detach(worker);
+    }
+    fprintf(stderr, "serving on %s with %d workers\n", path, workers);
+
+    while (!server_stopping) {
+        int client = accept(listener, NULL, NULL);
+        if (client < 0) {
+            continue;  // Interrupted by a signal, or a client that already gave up
+        }
+        pthread_mutex_lock(&connections.lock);
+        while (connections.count == SERVER_QUEUE_SIZE) {
+            pthread_cond_wait(&connections.space, &connections.lock);
+        }
+        connections.sockets[(connections.head + connections.count) % SERVER_QUEUE_SIZE] = client;
+        connections.count++;
+        pthread_cond_signal(&connections.ready);
+        pthread_mutex_unlock(&connections.lock);
+    }
+
+    close(listener);
+    unlink(path);
+    return 0;
+}
+
+// Function to run an algorithm over the trace on stdin and display the rows
+int run_sim_rows(const char *algorithm, const char *parameter_text) {
+    int n = 0;
+    Process_For_Sim *processes = read_trace_from_stdin(&n);
+    char error[160];
+
+    if (!simulate_algorithm_rows(algorithm, parameter_text, -1, processes, n, error, sizeof(error))) {
+        printf("Error: %s.\n", error);
+        free(processes);
+        return 1;
+    }
+    display_sim_rows(processes, n, response_sentinel(algorithm));
+
+    // Context switches, idle time, CPU utilization and throughput
+    if (options.stats) {
+        display_cpu_stats();
+    }
+    free(processes);
+    return 0;
+}
+
+// Functions for the replication mode
+//
+// One trace gives one noisy average. With --replicate <n> the trace on stdin is
+// a model of the workload instead: each of n replications draws a variant of it
+// and runs every algorithm named on the command line over that variant, as in
+// ./scheduler --replicate 1000 RR 4 SRT 0.5 < trace.csv. A variant has the
+// trace's row count and first arrival, and pids 1, 2, ... in arrival order.
+// --variant bootstrap (the default) draws every gap between arrivals from the
+// trace's gaps, and every row's response point, burst and fifth column from its
+// rows. --variant fitted draws exponential gaps and bursts with the trace's
+// means, with the response point at the trace's mean fraction of the burst.
+//
+// Replications are shared out over --threads threads (default one per CPU).
+// Each replication seeds its own random stream from --seed and its number, so
+// the variants are the same however many threads run them. Each thread keeps
+// running means and variances (Welford) of the three averages the table would
+// print, and the threads' figures are merged at the end. All algorithms see
+// the same variants, so the difference from the first algorithm is reported
+// too; its interval is usually much narrower than the two separate ones.
+
+#define REPLICATE_MAX_ALGORITHMS 16
+#define REPLICATE_METRICS 3  // Average waiting, turnaround and response time
+
+// Count, mean and sum of squared deviations of a stream of values
+typedef struct {
+    long long count;
+    double mean;
+    double m2;
+} Running_Stats;
+
+// Function to add a value to running statistics (Welford's update)
+void running_stats_add(Running_Stats *stats, double value) {
+    stats->count++;
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+}
+
+// Function to fold the statistics of another stream of values into stats
+void running_stats_merge(Running_Stats *stats, const Running_Stats *other) {
+    if (other->count == 0) {
+        return;
+    }
+    long long count = stats->count + other->count;
+    double delta = other->mean - stats->mean;
+    double weight = (double)other->count / count;
+    stats->m2 += other->m2 + delta * delta * stats->count * weight;
+    stats->mean += delta * weight;
+    stats->count = count;
+}
+
+// Function to return the two-sided 95% quantile of Student's t with the given degrees of freedom
+double t_quantile_95(long long degrees) {
+    static const double table[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                     2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                     2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degrees <= 30) {
+        return table[degrees - 1];
+    }
+    return 1.96 + (1.96 * 1.96 * 1.96 + 1.96) / (4.0 * degrees);  // First-order expansion around the normal
+}
+
+typedef struct {
+    const char *name;
+    const char *parameter;  // NULL if the algorithm takes none
+    char label[32];         // "RR 4"
+    int sentinel;           // Response-time sentinel of its table
+} Replication_Algorithm;
+
+// What every worker thread shares
+typedef struct {
+    const Process_For_Sim *trace;   // The model trace, sorted by arrival
+    int n;
+    int *gaps;                      // Bootstrap: gaps between consecutive arrivals of the trace
+    double mean_gap;                // Fitted: mean gap between arrivals
+    double mean_burst;              // Fitted: mean burst
+    double response_fraction;       // Fitted: mean of time until first response / burst
+    bool fitted;
+    Replication_Algorithm algorithms[REPLICATE_MAX_ALGORITHMS];
+    int algorithm_count;
+    long long replications;
+    atomic_llong next;              // Next replication to run
+} Replication_Job;
+
+// One worker thread's statistics
+typedef struct {
+    Replication_Job *job;
+    Running_Stats stats[REPLICATE_MAX_ALGORITHMS][REPLICATE_METRICS];
+    Running_Stats differences[REPLICATE_MAX_ALGORITHMS][REPLICATE_METRICS];  // From the first algorithm
+} Replication_Worker;
+
+// Function to return a uniform double in [0, 1)
+double random_unit(uint64_t *state) {
+    return (double)(random_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Function to draw one variant of the model trace into rows, in arrival order
+void draw_variant(const Replication_Job *job, uint64_t *state, Process_For_Sim rows[]) {
+    const Process_For_Sim *trace = job->trace;
+    int n = job->n;
+    long long time = trace[0].arrival_time;
+    for (int i = 0; i < n; i++) {
+        const Process_For_Sim *model = &trace[random_next(state) % (uint64_t)n];
+        Process_For_Sim *row = &rows[i];
+        memset(row, 0, sizeof(*row));
+        if (job->fitted) {
+            if (i > 0) time += (long long)(-job->mean_gap * log(1 - random_unit(state)) + 0.5);
+            row->burst_time = 1 + (int)(-(job->mean_burst - 1) * log(1 - random_unit(state)) + 0.5);
+            row->time_until_first_response = (int)(job->response_fraction * row->burst_time + 0.5);
+        } else {
+            if (i > 0) time += job->gaps[random_next(state) % (uint64_t)(n - 1)];
+            row->burst_time = model->burst_time;
+            row->time_until_first_response = model->time_until_first_response;
+        }
+        row->process_id = i + 1;
+        row->arrival_time = (time < INT_MAX) ? (int)time : INT_MAX;
+        row->optional_column = model->optional_column;
+        row->has_optional_column = model->has_optional_column;
+        row->input_index = i;
+    }
+}
+
+// Function run by each worker thread: take replications until none are left
+void *run_replication_worker(void *argument) {
+    Replication_Worker *worker = (Replication_Worker *)argument;
+    Replication_Job *job = worker->job;
+    Process_For_Sim *variant = (Process_For_Sim *)malloc(job->n * sizeof(Process_For_Sim));
+    Process_For_Sim *rows = (Process_For_Sim *)malloc(job->n * sizeof(Process_For_Sim));
+    if (variant == NULL || rows == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+
+    long long replication;
+    while ((replication = atomic_fetch_add(&job->next, 1)) < job->replications) {
+        uint64_t state = options.seed ^ ((uint64_t)replication * 0xD1B54A32D192ED03ULL);
+        draw_variant(job, &state, variant);
+
+        double first[REPLICATE_METRICS];
+        for (int a = 0; a < job->algorithm_count; a++) {
+            const Replication_Algorithm *algorithm = &job->algorithms[a];
+            char error[160];
+            Cpu_Stats fresh = {.last_dispatched = -1};
+            cpu_stats = fresh;
+            memcpy(rows, variant, job->n * sizeof(Process_For_Sim));
+            prepare_sim_rows(rows, job->n);
+            simulate_algorithm_rows(algorithm->name, algorithm->parameter, options.io_time, rows, job->n,
+                                    error, sizeof(error));  // Checked on the model trace already
+
+            double averages[REPLICATE_METRICS];
+            average_sim_rows(rows, job->n, algorithm->sentinel, averages);
+            for (int m = 0; m < REPLICATE_METRICS; m++) {
+                running_stats_add(&worker->stats[a][m], averages[m]);
+                if (a == 0) first[m] = averages[m];
+                else running_stats_add(&worker->differences[a][m], averages[m] - first[m]);
+            }
+        }
+    }
+
+    free(variant);
+    free(rows);
+    return NULL;
+}
+
+// Function to print one line of the replication results
+void display_replication_line(const char *label, const char *metric, const Running_Stats *stats) {
+    double error = sqrt(stats->m2 / (stats->count - 1) / stats->count);  // Standard error of the mean
+    double half_width = t_quantile_95(stats->count - 1) * error;
+    double low = stats->mean - half_width, high = stats->mean + half_width;
+
+    if (options.output == OUTPUT_CSV) {
+        printf("%s,%s,%lld,%.4f,%.4f,%.4f,%.4f\n", label, metric, stats->count, stats->mean, error, low, high);
+    } else if (options.output == OUTPUT_JSONL) {
+        printf("{\"algorithm\":\"%s\",\"metric\":\"%s\",\"replications\":%lld,\"mean\":%.4f,\"se\":%.4f,"
+               "\"ci_low\":%.4f,\"ci_high\":%.4f}\n", label, metric, stats->count, stats->mean, error, low, high);
+    } else {
+        printf("| %-22s | %-10s | %10.2f | %8.2f | %10.2f | %10.2f |\n", label, metric, stats->mean, error, low, high);
+    }
+}
+
+// Function to run n replications of every algorithm in args (names, each followed
+// by its parameter if it takes one) over variants of the trace on stdin
+int run_replications(int count, char *args[], long long n) {
+    const char *metrics[REPLICATE_METRICS] = {"waiting", "turnaround", "response"};
+    Replication_Job job;
+    memset(&job, 0, sizeof(job));
+
+    if (options.output == OUTPUT_BINARY) {
+        printf("Error: --replicate writes the table, csv or jsonl.\n");
+        return 1;
+    }
+
+    // Algorithms and their parameters
+    for (int i = 0; i < count; i++) {
+        if (job.algorithm_count == REPLICATE_MAX_ALGORITHMS) {
+            printf("Error: --replicate compares at most %d algorithms.\n", REPLICATE_MAX_ALGORITHMS);
+            return 1;
+        }
+        Replication_Algorithm *algorithm = &job.algorithms[job.algorithm_count++];
+        algorithm->name = args[i];
+        algorithm->parameter = (algorithm_needs_parameter(args[i]) && i + 1 < count) ? args[++i] : NULL;
+        snprintf(algorithm->label, sizeof(algorithm->label), "%s%s%s", algorithm->name,
+                 algorithm->parameter ? " " : "", algorithm->parameter ? algorithm->parameter : "");
+        int sentinel = response_sentinel(algorithm->name);
+        algorithm->sentinel = (sentinel == -2) ? -1 : sentinel;
+    }
+    if (job.algorithm_count == 0) {
+        printf("Error: No scheduling algorithm specified.\n");
+        return 1;
+    }
+
+    // The model trace and the figures the generators draw from
+    int rows_read = 0;
+    Process_For_Sim *trace = read_trace_from_stdin(&rows_read);
+    if (rows_read == 0) {
+        printf("Error: The trace has no rows.\n");
+        return 1;
+    }
+    job.trace = trace;
+    job.n = rows_read;
+    job.fitted = options.fitted_variants;
+    job.replications = n;
+    job.gaps = (int *)malloc(rows_read * sizeof(int));
+    if (job.gaps == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    double total_burst = 0, total_fraction = 0;
+    for (int i = 0; i < rows_read; i++) {
+        if (i > 0) job.gaps[i - 1] = trace[i].arrival_time - trace[i - 1].arrival_time;
+        total_burst += trace[i].burst_time;
+        total_fraction += (trace[i].burst_time > 0) ? (double)trace[i].time_until_first_response / trace[i].burst_time : 0;
+    }
+    job.mean_gap = (rows_read > 1) ? (double)(trace[rows_read - 1].arrival_time - trace[0].arrival_time) / (rows_read - 1) : 0;
+    job.mean_burst = (total_burst / rows_read > 1) ? total_burst / rows_read : 1;
+    job.response_fraction = total_fraction / rows_read;
+
+    // Check every algorithm once on a copy of the trace, so the workers can not fail
+    Process_For_Sim *check = (Process_For_Sim *)malloc(rows_read * sizeof(Process_For_Sim));
+    if (check == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    for (int a = 0; a < job.algorithm_count; a++) {
+        char error[160];
+        memcpy(check, trace, rows_read * sizeof(Process_For_Sim));
+        prepare_sim_rows(check, rows_read);
+        if (!simulate_algorithm_rows(job.algorithms[a].name, job.algorithms[a].parameter, options.io_time, check,
+                                     rows_read, error, sizeof(error))) {
+            printf("Error: %s.\n", error);
+            return 1;
+        }
+    }
+    free(check);
+
+    // Share the replications out over the threads
+    long long threads = (options.threads > 0) ? options.threads : sysconf(_SC_NPROCESSORS_ONLN);
+    if (threads < 1) threads = 1;
+    if (threads > n) threads = n;
+    Replication_Worker *workers = (Replication_Worker *)calloc(threads, sizeof(Replication_Worker));
+    pthread_t *thread_ids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (workers == NULL || thread_ids == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    atomic_init(&job.next, 0);
+    for (long long t = 0; t < threads; t++) {
+        workers[t].job = &job;
+        if (pthread_create(&thread_ids[t], NULL, run_replication_worker, &workers[t]) != 0) {
+            printf("Error: Could not start the replication threads.\n");
+            return 1;
+        }
+    }
+    for (long long t = 0; t < threads; t++) {
+        pthread_join(thread_ids[t], NULL);
+        if (t > 0) {
+            for (int a = 0; a < job.algorithm_count; a++) {
+                for (int m = 0; m < REPLICATE_METRICS; m++) {
+                    running_stats_merge(&workers[0].stats[a][m], &workers[t].stats[a][m]);
+                    running_stats_merge(&workers[0].differences[a][m], &workers[t].differences[a][m]);
+                }
+            }
+        }
+    }
+
+    // Mean, standard error and 95% confidence interval of each average
+    if (options.output == OUTPUT_CSV) {
+        printf("algorithm,metric,replications,mean,se,ci_low,ci_high\n");
+    } else if (options.output == OUTPUT_TABLE) {
+        printf("Replications: %lld %s variants of %d rows on %lld thread%s\n\n", n,
+               job.fitted ? "fitted" : "bootstrap", rows_read, threads, (threads == 1) ? "" : "s");
+        printf("+------------------------+------------+------------+----------+------------+------------+\n");
+        printf("| Algorithm              | Average    |       Mean |       SE |   95%% low  |  95%% high  |\n");
+        printf("+------------------------+------------+------------+----------+------------+------------+\n");
+    }
+    for (int a = 0; a < job.algorithm_count; a++) {
+        for (int m = 0; m < REPLICATE_METRICS; m++) {
+            display_replication_line(job.algorithms[a].label, metrics[m], &workers[0].stats[a][m]);
+        }
+    }
+    for (int a = 1; a < job.algorithm_count; a++) {
+        char label[80];
+        snprintf(label, sizeof(label), "%s - %s", job.algorithms[a].label, job.algorithms[0].label);
+        for (int m = 0; m < REPLICATE_METRICS; m++) {
+            display_replication_line(label, metrics[m], &workers[0].differences[a][m]);
+        }
+    }
+    if (options.output == OUTPUT_TABLE) {
+        printf("+------------------------+------------+------------+----------+------------+------------+\n");
+    }
+
+    free(workers);
+    free(thread_ids);
+    free(job.gaps);
+    free(trace);
+    return 0;
+}
+
+// Functions for the result cache
+//
+// With --cache <dir> (or the SCHEDULER_CACHE environment variable) a run is
+// looked up in a directory of earlier results before anything is parsed. The
+// key is a hash of the input bytes together with the command line, so the
+// algorithm, its parameter and every option that changes the output are part
+// of it. An entry is one file, named after the key, with a fixed header, the
+// command line, and the output exactly as the run wrote it (sequence line,
+// table or records, and statistics, in whichever format was asked for). A hit
+// maps the file and writes that output in one go. A miss runs as usual with
+// stdout captured in a temporary file, which is copied out at the end and, if
+// the run succeeded, renamed into place. --no-cache ignores the cache, and
+// --cache-refresh runs again and replaces the entry. Runs that write other
+// files (--incremental, --timeline) or serve requests are never cached.
+
+#define CACHE_MAGIC "SCHEDRC1"
+
+// Header at the start of a cache entry; the command line and the output follow it
+typedef struct {
+    char magic[8];            // CACHE_MAGIC
+    uint64_t input_hash[2];   // Hash of the input bytes
+    uint64_t input_length;    // Length of the input in bytes
+    uint64_t key_length;      // Length of the command line that follows the header
+    uint64_t output_length;   // Length of the output that follows the command line
+} Cache_Header;
+
+// State of a run whose output is being captured for the cache
+typedef struct {
+    bool capturing;           // stdout currently goes to the temporary file
+    int saved_stdout;         // The real stdout while capturing
+    int file;                 // The temporary file
+    char path[PATH_MAX];      // Where the entry goes
+    char temporary[PATH_MAX + 32]; // Where it is written first
+    Cache_Header header;
+    const char *key;          // Command line of the run
+} Result_Cache;
+
+Result_Cache result_cache = {.capturing = false, .saved_stdout = -1, .file = -1};
+
+// Function to hash the input, eight bytes at a time on four lanes
+void hash_input(const unsigned char *data, size_t length, uint64_t hash[2]) {
+    uint64_t lanes[4] = {HASH_SEED, 0x9E3779B97F4A7C15ULL, 0xC2B2AE3D27D4EB4FULL, 0x165667B19E3779F9ULL};
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        for (int lane = 0; lane < 4; lane++) {
+            uint64_t word;
+            memcpy(&word, data + i + 8 * lane, sizeof(word));
+            lanes[lane] = (lanes[lane] ^ word) * 0x9E3779B97F4A7C15ULL;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    // The tail goes through FNV-1a, then the lanes are folded into two halves
+    uint64_t tail = hash_bytes(data + i, length - i, HASH_SEED ^ length);
+    hash[0] = hash_bytes(&lanes[0], 2 * sizeof(uint64_t), tail);
+    hash[1] = hash_bytes(&lanes[2], 2 * sizeof(uint64_t), tail * 0xFF51AFD7ED558CCDULL);
+}
+
+// Function to join the command line, without the cache options, into the cache key
+char *cache_key(int argc, char *argv[], size_t *length) {
+    size_t size = 1;
+    for (int i = 1; i < argc; i++) size += strlen(argv[i]) + 1;
+    char *key = (char *)malloc(size);
+    if (key == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    size_t used = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            i++;
+            continue;
+        }
+        if (strcmp(argv[i], "--no-cache") == 0 || strcmp(argv[i], "--cache-refresh") == 0) continue;
+        size_t argument_length = strlen(argv[i]);
+        memcpy(key + used, argv[i], argument_length);
+        used += argument_length;
+        key[used++] = '\0';  // Arguments can not contain a NUL, so the joined key is unambiguous
+    }
+    key[used] = '\0';
+    *length = used;
+    return key;
+}
+
+// Function to write a cached entry to stdout if it matches; false if there is none
+bool cache_replay(const char *path, const Cache_Header *expected, const char *key) {
+    int file = open(path, O_RDONLY);
+    if (file < 0) return false;
+    struct stat status;
+    bool replayed = false;
+    if (fstat(file, &status) == 0 && (size_t)status.st_size >= sizeof(Cache_Header)) {
+        const char *entry = (const char *)mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (entry != MAP_FAILED) {
+            Cache_Header header;
+            memcpy(&header, entry, sizeof(header));
+            // A short, foreign or colliding entry is treated as a miss
+            if (memcmp(header.magic, CACHE_MAGIC, 8) == 0 && header.input_hash[0] == expected->input_hash[0] &&
+                header.input_hash[1] == expected->input_hash[1] && header.input_length == expected->input_length &&
+                header.key_length == expected->key_length &&
+                sizeof(header) + header.key_length + header.output_length == (uint64_t)status.st_size &&
+                memcmp(entry + sizeof(header), key, header.key_length) == 0) {
+                fflush(stdout);
+                replayed = write_fully(STDOUT_FILENO, entry + sizeof(header) + header.key_length, header.output_length);
+            }
+            munmap((void *)entry, (size_t)status.st_size);
+        }
+    }
+    close(file);
+    return replayed;
+}
+
+// Function to end the capture: restore stdout, copy the output to it and keep the entry if asked
+void cache_finish(bool store) {
+    if (!result_cache.capturing) return;
+    result_cache.capturing = false;
+    fflush(stdout);
+    dup2(result_cache.saved_stdout, STDOUT_FILENO);
+    close(result_cache.saved_stdout);
+
+    // Copy the captured output to the real stdout
+    off_t end = lseek(result_cache.file, 0, SEEK_END);
+    off_t start = (off_t)(sizeof(Cache_Header) + result_cache.header.key_length);
+    bool copied = end >= start;
+    if (copied && end > start) {
+        char *entry = (char *)mmap(NULL, (size_t)end, PROT_READ, MAP_SHARED, result_cache.file, 0);
+        copied = entry != MAP_FAILED && write_fully(STDOUT_FILENO, entry + start, (size_t)(end - start));
+        if (entry != MAP_FAILED) munmap(entry, (size_t)end);
+    }
+
+    // Fill in the header last, so an unfinished entry never looks valid
+    if (store && copied) {
+        result_cache.header.output_length = (uint64_t)(end - start);
+        store = pwrite(result_cache.file, &result_cache.header, sizeof(Cache_Header), 0) == (ssize_t)sizeof(Cache_Header) &&
+                rename(result_cache.temporary, result_cache.path) == 0;
+    }
+    if (!store || !copied) {
+        unlink(result_cache.temporary);
+    }
+    close(result_cache.file);
+}
+
+// Function to end an unfinished capture on exit (registered with atexit)
+void cache_abandon(void) {
+    cache_finish(false);
+}
+
+// Function to look the run up in the cache directory: true if its output was replayed,
+// otherwise the input stays readable on stdin and the output is captured for the entry
+bool cache_open(const char *directory, const char *key, size_t key_length, bool refresh) {
+    // Map the input if it is a file, otherwise read it all and read the rows back from memory
+    const unsigned char *input = NULL;
+    size_t input_length = 0;
+    struct stat status;
+    off_t offset = lseek(STDIN_FILENO, 0, SEEK_CUR);
+    if (fstat(STDIN_FILENO, &status) == 0 && S_ISREG(status.st_mode) && offset >= 0 && status.st_size > offset) {
+        const unsigned char *mapped = (const unsigned char *)mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, STDIN_FILENO, 0);
+        if (mapped == MAP_FAILED) {
+            printf("Error: Could not map the input for the cache.\n");
+            exit(1);
+        }
+        input = mapped + offset;
+        input_length = (size_t)(status.st_size - offset);
+    } else {
+        Byte_Buffer buffer = {NULL, 0, 0};
+        char block[65536];
+        size_t got;
+        while ((got = fread(block, 1, sizeof(block), stdin)) > 0) buffer_append(&buffer, block, got);
+        if (buffer.used > 0) {
+            FILE *memory = fmemopen(buffer.data, buffer.used, "r");
+            if (memory == NULL) {
+                printf("Error: Could not read the input back for the cache.\n");
+                exit(1);
+            }
+            stdin = memory;
+        }
+        input = (const unsigned char *)buffer.data;
+        input_length = buffer.used;
+    }
+
+    // The entry is named after the hash of the input and the command line
+    Cache_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, 8);
+    hash_input(input, input_length, header.input_hash);
+    header.input_length = input_length;
+    header.key_length = key_length;
+    uint64_t name = hash_bytes(key, key_length, header.input_hash[0]);
+    if (snprintf(result_cache.path, sizeof(result_cache.path), "%s/%016llx%016llx.res", directory,
+                 (unsigned long long)name, (unsigned long long)header.input_hash[1]) >= (int)sizeof(result_cache.path)) {
+        printf("Error: Cache directory path is too long.\n");
+        exit(1);
+    }
+    if (!refresh && cache_replay(result_cache.path, &header, key)) {
+        return true;
+    }
+
+    // Start the entry: header (completed at the end), command line, then whatever the run prints
+    if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+        printf("Error: Could not create the cache directory '%s'.\n", directory);
+        exit(1);
+    }
+    snprintf(result_cache.temporary, sizeof(result_cache.temporary), "%s.%ld.tmp", result_cache.path, (long)getpid());
+    result_cache.file = open(result_cache.temporary, O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (result_cache.file < 0) {
+        printf("Error: Could not write to the cache directory '%s'.\n", directory);
+        exit(1);
+    }
+    Cache_Header placeholder;
+    memset(&placeholder, 0, sizeof(placeholder));
+    if (!write_fully(result_cache.file, (const char *)&placeholder, sizeof(placeholder)) ||
+        !write_fully(result_cache.file, key, key_length)) {
+        printf("Error: Could not write to the cache directory '%s'.\n", directory);
+        unlink(result_cache.temporary);
+        exit(1);
+    }
+    result_cache.header = header;
+    result_cache.key = key;
+    fflush(stdout);
+    result_cache.saved_stdout = dup(STDOUT_FILENO);
+    dup2(result_cache.file, STDOUT_FILENO);
+    result_cache.capturing = true;
+    atexit(cache_abandon);
+    return false;
+}
+
+// Function to take the --name value options out of argv, leaving the algorithm and its parameter
+void parse_options(int *argc, char *argv[]) {
+    int kept = 1;
+    for (int i = 1; i < *argc; i++) {
+        if (strncmp(argv[i], "--", 2) != 0) {
+            argv[kept++] = argv[i];
+            continue;
+        }
+        if (strcmp(argv[i], "--incremental") == 0 && i + 1 < *argc) {
+            options.incremental_state = argv[++i];
+        } else if (strcmp(argv[i], "--quanta") == 0 && i + 1 < *argc) {
+            options.quanta = argv[++i];
+        } else if (strcmp(argv[i], "--boost") == 0 && i + 1 < *argc) {
+            options.boost_period = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--latency") == 0 && i + 1 < *argc) {
+            options.latency = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < *argc) {
+            options.seed = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--predictor") == 0 && i + 1 < *argc) {
+            i++;
+            if (strcmp(argv[i], "exponential") == 0) options.predictor = PREDICTOR_EXPONENTIAL;
+            else if (strcmp(argv[i], "window") == 0) options.predictor = PREDICTOR_WINDOW;
+            else if (strcmp(argv[i], "holt") == 0) options.predictor = PREDICTOR_HOLT;
+            else {
+                printf("Error: Unknown predictor '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--window") == 0 && i + 1 < *argc) {
+            options.window = atoi(argv[++i]);
+            if (options.window < 1 || options.window > PREDICTOR_WINDOW_MAX) {
+                printf("Error: --window must be between 1 and %d.\n", PREDICTOR_WINDOW_MAX);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--beta") == 0 && i + 1 < *argc) {
+            options.beta = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--cs-cost") == 0 && i + 1 < *argc) {
+            options.switch_cost = atoi(argv[++i]);
+            options.stats = true;
+        } else if (strcmp(argv[i], "--cache-refill") == 0 && i + 1 < *argc) {
+            options.cache_refill = atoi(argv[++i]);
+            options.stats = true;
+        } else if (strcmp(argv[i], "--timeline") == 0 && i + 1 < *argc) {
+            options.timeline = argv[++i];
+        } else if (strcmp(argv[i], "--timeline-format") == 0 && i + 1 < *argc) {
+            i++;
+            if (strcmp(argv[i], "json") == 0) options.timeline_binary = false;
+            else if (strcmp(argv[i], "bin") == 0) options.timeline_binary = true;
+            else {
+                printf("Error: Unknown timeline format '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--pipeline") == 0) {
+            options.pipeline = true;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            options.stats = true;
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < *argc) {
+            i++;
+            if (strcmp(argv[i], "table") == 0) options.output = OUTPUT_TABLE;
+            else if (strcmp(argv[i], "csv") == 0) options.output = OUTPUT_CSV;
+            else if (strcmp(argv[i], "jsonl") == 0) options.output = OUTPUT_JSONL;
+            else if (strcmp(argv[i], "bin") == 0) options.output = OUTPUT_BINARY;
+            else {
+                printf("Error: Unknown output format '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            options.quiet = true;
+        } else if (strcmp(argv[i], "--replicate") == 0 && i + 1 < *argc) {
+            options.replications = atoll(argv[++i]);
+            if (options.replications < 2) {
+                printf("Error: --replicate needs at least 2 replications.\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--variant") == 0 && i + 1 < *argc) {
+            i++;
+            if (strcmp(argv[i], "bootstrap") == 0) options.fitted_variants = false;
+            else if (strcmp(argv[i], "fitted") == 0) options.fitted_variants = true;
+            else {
+                printf("Error: Unknown variant '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < *argc) {
+            options.threads = atoi(argv[++i]);
+            if (options.threads < 1) {
+                printf("Error: --threads must be at least 1.\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--cores") == 0 && i + 1 < *argc) {
+            options.cores = atoi(argv[++i]);
+            if (options.cores < 1) {
+                printf("Error: --cores must be at least 1.\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--runqueue") == 0 && i + 1 < *argc) {
+            i++;
+            if (strcmp(argv[i], "global") == 0) options.per_core_queues = false;
+            else if (strcmp(argv[i], "percore") == 0) options.per_core_queues = true;
+            else {
+                printf("Error: Unknown run queue '%s'.\n", argv[i]);
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--balance") == 0 && i + 1 < *argc) {
+            options.balance_period = atoi(argv[++i]);
+            if (options.balance_period < 0) {
+                printf("Error: --balance must not be negative.\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < *argc) {
+            options.cache = argv[++i];
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            options.no_cache = true;
+        } else if (strcmp(argv[i], "--cache-refresh") == 0) {
+            options.cache_refresh = true;
+        } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < *argc) {
+            options.serve = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0 && i + 1 < *argc) {
+            options.workers = atoi(argv[++i]);
+            if (options.workers < 1) {
+                printf("Error: --workers must be at least 1.\n");
+                exit(1);
+            }
+        } else if (strcmp(argv[i], "--io") == 0 && i + 1 < *argc) {
+            options.io_time = atoi(argv[++i]);
+            if (options.io_time < 0) {
+                printf("Error: --io must not be negative.\n");
+                exit(1);
+            }
+        } else {
+            printf("Error: Unknown or incomplete option '%s'.\n", argv[i]);
+            exit(1);
+        }
+    }
+    argv[kept] = NULL;
+    *argc = kept;
+}
+
+#if !defined(SCHED_DIFFTEST) && !defined(SCHED_BENCHMARK)
+// Function to run the mode and algorithm left on the command line after the options
+int run_command(int argc, char *argv[]) {
+    // Server mode takes the algorithm from each request instead
+    if (options.serve != NULL) {
+        if (argc != 1 || options.incremental_state != NULL || options.timeline != NULL || options.pipeline || options.cores > 0) {
+            printf("Error: --serve takes no algorithm and can not be combined with --incremental, --timeline, --pipeline or --cores.\n");
+            return 1;
+        }
+        if (options.switch_cost < 0 || options.cache_refill < 0) {
+            printf("Error: --cs-cost and --cache-refill must not be negative.\n");
+            return 1;
+        }
+        sequence_output_enabled = false;
+        return run_server(options.serve, options.workers);
+    }
+
+    // Replications take any number of algorithms
+    if (options.replications > 0) {
+        if (options.incremental_state != NULL || options.timeline != NULL || options.pipeline || options.cores > 0) {
+            printf("Error: --replicate can not be combined with --incremental, --timeline, --pipeline or --cores.\n");
+            return 1;
+        }
+        if (options.switch_cost < 0 || options.cache_refill < 0) {
+            printf("Error: --cs-cost and --cache-refill must not be negative.\n");
+            return 1;
+        }
+        sequence_output_enabled = false;
+        return run_replications(argc - 1, argv + 1, options.replications);
+    }
+
+    // Check if there are more than 3 arguments or no algorithm is specified
+    if (argc < 2 || argc > 3) {
+        printf("Error: No scheduling algorithm specified.\n");
+        return 1;
+    }
+
+    if (options.switch_cost < 0 || options.cache_refill < 0) {
+        printf("Error: --cs-cost and --cache-refill must not be negative.\n");
+        return 1;
+    }
+
+    // Only the table comes with the sequence line
+    if (options.output != OUTPUT_TABLE || options.quiet) {
+        sequence_output_enabled = false;
+    }
+
+    // Incremental mode reads the trace itself, for any of the algorithms below
+    if (options.incremental_state != NULL) {
+        if (options.stats || options.timeline != NULL || options.pipeline || options.cores > 0) {
+            printf("Error: --incremental can not be combined with --cs-cost, --cache-refill, --stats, --timeline, --pipeline or --cores.\n");
+            return 1;
+        }
+        return run_incremental(argv[1], (argc == 3) ? argv[2] : NULL);
+    }
+
+    // The timeline file is completed on every way out, including errors
+    if (options.timeline != NULL) {
+        timeline_open(options.timeline, options.timeline_binary);
+        atexit(timeline_close);
+    }
+
+    // The SMP mode runs every row as one job on --cores CPUs
+    if (options.cores > 0) {
+        if (options.pipeline || options.io_time >= 0) {
+            printf("Error: --cores can not be combined with --pipeline or --io.\n");
+            return 1;
+        }
+        return run_smp(argv[1], (argc == 3) ? argv[2] : NULL);
+    }
+
+    // The pipelined mode runs the multi-burst engine (without I/O unless --io is given)
+    if (options.pipeline) {
+        return run_pipelined(argv[1], (argc == 3) ? argv[2] : NULL, (options.io_time >= 0) ? options.io_time : 0);
+    }
+
+    // With --io the classic algorithms run over multi-burst processes
+    if (options.io_time >= 0) {
+        return run_multiburst(argv[1], (argc == 3) ? argv[2] : NULL, options.io_time);
+    }
+
+    // The classic display functions only print the table, so other formats go through the shared rows
+    if (options.output != OUTPUT_TABLE && response_sentinel(argv[1]) != -2) {
+        return run_sim_rows(argv[1], (argc == 3) ? argv[2] : NULL);
+    }
+
+    // If the scheduling algorithm is FCFS (First Come First Serve)
+    if (strcmp(argv[1], "FCFS") == 0) {
+        Process_For_FCFS processes[MAX_PROCESSES];  // Array to store processes
+        int n = 0;  // Number of processes
+        
+        char buffer[BUFFER_SIZE];  // Buffer to read input
+
+        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
+
+        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
+        while (fgets(buffer, sizeof(buffer), stdin)) {
+            // Parse input and populate the process array
+            if (sscanf(buffer, "%d,%d,%d,%d", 
+                    &processes[n].process_id, 
+                    &processes[n].arrival_time, 
+                    &processes[n].time_until_first_response, 
+                    &processes[n].burst_time) == 4) {
+                n++;  // Increment process count
+            }
+        }
+
+        // Sort the processes by arrival time
+        sort_same_arrival_time_processes_fcfs(processes, n);
+
+        // Simulate the FCFS algorithm
+        simulate_fcfs(processes, n);
+
+        // Print process values and averages
+        print_values(processes, n);
+    } 
+    
+    // If the scheduling algorithm is SJF (Shortest Job First)
+    else if (strcmp(argv[1], "SJF") == 0) {
+        Process_For_SJF processes[MAX_PROCESSES];  // Array to store processes
+        int n = 0;  // Number of processes
+        
+        char buffer[BUFFER_SIZE];  // Buffer to read input
+        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
+        
+        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
+        while (fgets(buffer, sizeof(buffer), stdin)) {
+            // Parse input and populate the process array
+            if (sscanf(buffer, "%d,%d,%d,%d", 
+                    &processes[n].process_id, 
+                    &processes[n].arrival_time, 
+                    &processes[n].time_until_first_response, 
+                    &processes[n].burst_time) == 4) {
+                processes[n].finished = false;  // Initialize process as not finished
+                n++;  // Increment process count
+            }
+        }
+        
+        // Sort processes by arrival time
+        sort_same_arrival_time_processes_sjf(processes, n);
+
+        // Simulate the Shortest Job Next (SPN) algorithm (non-preemptive SJF)
+        simulateSPN(processes, n);
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_sjf(processes, n);
+    }
+    
+    // If the scheduling algorithm is Priority
+    else if (strcmp(argv[1], "Priority") == 0) {
+        Process_For_Priority processes[MAX_PROCESSES];  // Array to store processes
+        int n = 0;  // Number of processes
+        char buffer[BUFFER_SIZE];  // Buffer to read input
+        fgets(buffer, sizeof(buffer), stdin);  // Skip the first line (header)
+
+        // Read processes in the format: Pid, Arrival Time, Time until first Response, Burst Length
+        while (fgets(buffer, sizeof(buffer), stdin)) {
+            // Parse input and populate the process array
+            if (sscanf(buffer, "%d,%d,%d,%d", 
+                    &processes[n].process_id, 
+                    &processes[n].arrival_time, 
+                    &processes[n].time_until_first_response, 
+                    &processes[n].burst_time) == 4) {
+                // Calculate priority as 1 / Process ID (lower process ID = higher priority)
+                processes[n].priority = (float) 1.0 / (processes[n].process_id);  
+                processes[n].start_time = -1;  // Start time is initially -1 (hasn't started yet)
+                processes[n].completed = false;  // Mark process as not completed
+                n++;  // Increment process count
+            }
+        }
+
+        // Sort processes by arrival time
+        sort_same_arrival_time_processes_priority(processes, n);
+
+        // Simulate the Priority scheduling algorithm
+        calculate_times(processes, n);
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_priority(processes, n);
+    }
+    
+    // If the scheduling algorithm is Round Robin (RR)
     else if (argc == 3 && (strcmp(argv[1], "RR") == 0)) {
         Process_For_RR processes[MAX_PROCESSES];  // Array to store processes
         int n = 0;  // Number of processes
@@ -1087,6 +6533,8 @@ int main(int argc, char *argv[]) {
                 processes[n].remaining_time = processes[n].burst_time;  // Initially, remaining time is the burst time
                 processes[n].first_response = false;  // Has not yet responded
                 processes[n].start_time = -1;  // Start time is initially -1 (hasn't started yet)
+                processes[n].response_time = -1;  // Stays -1 if the response point is never reached
+                processes[n].completed = false;  // Mark process as not completed
                 n++;  // Increment process count
             }
         }
@@ -1136,11 +6584,595 @@ int main(int argc, char *argv[]) {
         display_and_calculate_averages_srt(processes, n);
     }
     
+    // If the scheduling algorithm is a multi-level feedback queue
+    else if (argc == 3 && (strcmp(argv[1], "MLFQ") == 0)) {
+        int levels = atoi(argv[2]);  // Number of levels is the second argument
+        if (levels < 1 || levels > MLFQ_MAX_LEVELS) {
+            printf("Error: MLFQ needs between 1 and %d levels.\n", MLFQ_MAX_LEVELS);
+            return 1;
+        }
+        int quanta[MLFQ_MAX_LEVELS];
+        parse_mlfq_quanta(options.quanta, quanta, levels);
+
+        int n = 0;
+        Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+        // Simulate MLFQ with the given levels, quanta and boost period
+        simulateMLFQ(processes, n, levels, quanta, options.boost_period);
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_sim(processes, n);
+        free(processes);
+    }
+
+    // If the scheduling algorithm is CFS (completely fair scheduling)
+    else if (argc == 3 && (strcmp(argv[1], "CFS") == 0)) {
+        int min_granularity = atoi(argv[2]);  // Minimum granularity is the second argument
+        if (min_granularity < 1 || options.latency < 1) {
+            printf("Error: CFS needs a positive minimum granularity and latency.\n");
+            return 1;
+        }
+
+        int n = 0;
+        Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+        // Simulate CFS with the given minimum granularity
+        simulateCFS(processes, n, min_granularity, options.latency);
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_sim(processes, n);
+        free(processes);
+    }
+
+    // If the scheduling algorithm is preemptive priority with aging
+    else if (argc == 3 && (strcmp(argv[1], "PriorityAging") == 0)) {
+        int aging_period = atoi(argv[2]);  // Aging period is the second argument (0 = no aging)
+
+        int n = 0;
+        Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+        // Simulate preemptive priority scheduling with the given aging period
+        if (!simulate_priority_aging(processes, n, aging_period)) {
+            printf("Error: PriorityAging priorities (or pids, without a fifth column) must span fewer than %d levels.\n", AGING_MAX_LEVELS);
+            free(processes);
+            return 1;
+        }
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_sim(processes, n);
+        free(processes);
+    }
+
+    // If the scheduling algorithm is stride or lottery scheduling
+    else if (argc == 3 && (strcmp(argv[1], "Stride") == 0 || strcmp(argv[1], "Lottery") == 0)) {
+        int quantum = atoi(argv[2]);  // Quantum time is the second argument
+        if (quantum < 1) {
+            printf("Error: %s needs a positive quantum.\n", argv[1]);
+            return 1;
+        }
+
+        int n = 0;
+        Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+        // Simulate proportional-share scheduling with the given quantum
+        if (strcmp(argv[1], "Stride") == 0) {
+            simulate_stride(processes, n, quantum);
+        } else {
+            simulate_lottery(processes, n, quantum, options.seed);
+        }
+
+        // Display results and calculate average wait, turnaround, and response times
+        display_and_calculate_averages_sim(processes, n);
+        free(processes);
+    }
+
+    // If the scheduling algorithm is EDF (earliest deadline first), preemptive or not
+    else if (strcmp(argv[1], "EDF") == 0 || strcmp(argv[1], "EDF-NP") == 0) {
+        int n = 0;
+        Process_For_Sim *processes = read_trace_from_stdin(&n);
+
+        // Simulate EDF scheduling
+        simulate_edf(processes, n, strcmp(argv[1], "EDF") == 0);
+
+        // Display results, average times and deadline statistics
+        display_and_calculate_averages_sim(processes, n);
+        display_deadline_statistics(processes, n);
+        free(processes);
+    }
+
     // If the specified algorithm is not recognized
     else {
         printf("Error: Unsupported scheduling algorithm '%s'.\n", argv[1]);
         return 1;  // Return with an error code
     }
 
+    // Context switches, idle time, CPU utilization and throughput
+    if (options.stats) {
+        display_cpu_stats();
+    }
+
     return 0;  // Return success
 }
+
+int main(int argc, char *argv[]) {
+    PROFILE_INIT();
+    size_t key_length = 0;
+    char *key = cache_key(argc, argv, &key_length);
+    parse_options(&argc, argv);
+
+    // Runs that only write to stdout can come from, and go into, the result cache
+    const char *cache = (options.cache != NULL) ? options.cache : getenv("SCHEDULER_CACHE");
+    if (cache != NULL && *cache != '\0' && !options.no_cache && options.serve == NULL &&
+        options.incremental_state == NULL && options.timeline == NULL) {
+        if (cache_open(cache, key, key_length, options.cache_refresh)) {
+            free(key);
+            return 0;
+        }
+    }
+
+    int status = run_command(argc, argv);
+    cache_finish(status == 0);
+    free(key);
+    return status;
+}
+#endif
+
+#ifdef SCHED_DIFFTEST
+
+// Differential test harness
+//
+// Built with -DSCHED_DIFFTEST this file has a different main, which checks
+// the faster engines against the classic simulators. It generates random
+// traces, runs each through simulate_sim_rows (the classic tick-based code,
+// quirks included), or simulate_edf for EDF, and through every engine in
+// difftest_engines, and compares
+// the completion sequence and the per-row start, completion, waiting and
+// response times. A failing trace is shrunk, by dropping rows and lowering
+// values while it still fails, and printed as a CSV trace for the normal
+// build. Engines that treat rows sharing a pid differently from the classic
+// simulators only get traces with unique pids. The SMP engines run on one
+// core, and skip RR, whose classic code cycles over the rows in arrival order
+// rather than keeping a first in, first out queue. EDF traces get a deadline
+// column, with some rows left without one and some given a negative one.
+// Before the engines it runs MLFQ with every level count it accepts.
+//
+//     gcc -O2 -pthread -DSCHED_DIFFTEST -o scheduler_difftest schedulerFile.c -lm
+//     ./scheduler_difftest [cases] [seed]
+
+#define DIFFTEST_MAX_ROWS 40
+
+// One row of a generated trace
+typedef struct {
+    int pid;
+    int arrival;
+    int ttfr;
+    int burst;
+    int deadline;       // Relative deadline, the fifth column
+    bool has_deadline;  // Whether the row has the fifth column
+} Difftest_Row;
+
+// An engine under test, run in place of the classic simulator for algorithm
+typedef struct {
+    const char *name;
+    bool repeated_pids;  // Whether rows may share a pid
+    const char *skip;    // Algorithm the engine schedules differently on purpose (NULL = none)
+    void (*run)(const char *algorithm, float parameter, Process_For_Sim rows[], int n);
+} Difftest_Engine;
+
+// Function to run the multi-burst engine without I/O, which has to match the classic simulators
+void difftest_run_multiburst(const char *algorithm, float parameter, Process_For_Sim rows[], int n) {
+    Policy policy;
+    policy_from_name(algorithm, &policy);
+    simulate_multiburst(rows, n, policy, (int)parameter, parameter, 0);
+}
+
+// Function to run the SMP simulator on one core with a global run queue
+void difftest_run_smp_global(const char *algorithm, float parameter, Process_For_Sim rows[], int n) {
+    Policy policy;
+    policy_from_name(algorithm, &policy);
+    Smp_State smp;
+    simulate_smp(&smp, rows, n, policy, (int)parameter, parameter, 1, false, 0);
+    free_smp(&smp);
+}
+
+// Function to run the SMP simulator on one core with a per-core run queue
+void difftest_run_smp_percore(const char *algorithm, float parameter, Process_For_Sim rows[], int n) {
+    Policy policy;
+    policy_from_name(algorithm, &policy);
+    Smp_State smp;
+    simulate_smp(&smp, rows, n, policy, (int)parameter, parameter, 1, true, 100);
+    free_smp(&smp);
+}
+
+const Difftest_Engine difftest_engines[] = {
+    {"multiburst", false, NULL, difftest_run_multiburst},
+    {"smp-global", false, "RR", difftest_run_smp_global},    // Its RR queue is first in, first out
+    {"smp-percore", false, "RR", difftest_run_smp_percore},
+};
+
+const char *difftest_algorithms[] = {"FCFS", "SJF", "Priority", "RR", "SRT", "EDF"};
+
+// Function to turn a generated trace into sorted rows, as read_trace_from_stdin would
+void difftest_load_rows(const Difftest_Row trace[], int n, Process_For_Sim rows[]) {
+    for (int i = 0; i < n; i++) {
+        memset(&rows[i], 0, sizeof(rows[i]));
+        rows[i].process_id = trace[i].pid;
+        rows[i].arrival_time = trace[i].arrival;
+        rows[i].time_until_first_response = trace[i].ttfr;
+        rows[i].burst_time = trace[i].burst;
+        rows[i].optional_column = trace[i].has_deadline ? trace[i].deadline : 0;
+        rows[i].has_optional_column = trace[i].has_deadline;
+        rows[i].input_index = i;
+    }
+    qsort(rows, n, sizeof(Process_For_Sim), compare_sim_rows);
+    for (int i = 0; i < n; i++) {
+        rows[i].remaining_time = rows[i].burst_time;
+        rows[i].start_time = -1;
+        rows[i].completion_time = -1;
+        rows[i].response_time = -1;
+    }
+}
+
+// Function to list the pids of rows in completion order
+void difftest_sequence(const Process_For_Sim rows[], int n, int sequence[]) {
+    Completion_Entry order[DIFFTEST_MAX_ROWS];
+    for (int i = 0; i < n; i++) {
+        order[i].completion_time = rows[i].completion_time;
+        order[i].index = i;
+    }
+    qsort(order, n, sizeof(Completion_Entry), compare_completions);
+    for (int i = 0; i < n; i++) {
+        sequence[i] = rows[order[i].index].process_id;
+    }
+}
+
+// Function to run the simulator the engines are checked against
+void difftest_reference(const char *algorithm, float parameter, Process_For_Sim rows[], int n) {
+    if (strcmp(algorithm, "EDF") == 0) {
+        simulate_edf(rows, n, true);
+    } else {
+        simulate_sim_rows(algorithm, parameter, rows, n, 0, NULL, 0);
+    }
+}
+
+// Function to run one case; returns false and describes the first difference if the engine disagrees
+bool difftest_case(const Difftest_Engine *engine, const char *algorithm, float parameter,
+                   const Difftest_Row trace[], int n, char *difference, size_t size) {
+    Process_For_Sim expected[DIFFTEST_MAX_ROWS], actual[DIFFTEST_MAX_ROWS];
+    difftest_load_rows(trace, n, expected);
+    difftest_load_rows(trace, n, actual);
+    difftest_reference(algorithm, parameter, expected, n);
+    engine->run(algorithm, parameter, actual, n);
+
+    int expected_sequence[DIFFTEST_MAX_ROWS], actual_sequence[DIFFTEST_MAX_ROWS];
+    difftest_sequence(expected, n, expected_sequence);
+    difftest_sequence(actual, n, actual_sequence);
+    for (int i = 0; i < n; i++) {
+        if (expected_sequence[i] != actual_sequence[i]) {
+            snprintf(difference, size, "sequence position %d: pid %d (reference) vs pid %d", i, expected_sequence[i], actual_sequence[i]);
+            return false;
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        const char *field = NULL;
+        int want = 0, got = 0;
+        if (expected[i].start_time != actual[i].start_time) {
+            field = "start"; want = expected[i].start_time; got = actual[i].start_time;
+        } else if (expected[i].completion_time != actual[i].completion_time) {
+            field = "completion"; want = expected[i].completion_time; got = actual[i].completion_time;
+        } else if (expected[i].waiting_time != actual[i].waiting_time) {
+            field = "waiting"; want = expected[i].waiting_time; got = actual[i].waiting_time;
+        } else if (expected[i].response_time != actual[i].response_time) {
+            field = "response"; want = expected[i].response_time; got = actual[i].response_time;
+        }
+        if (field != NULL) {
+            snprintf(difference, size, "pid %d arriving at %d: %s %d (reference) vs %d",
+                     expected[i].process_id, expected[i].arrival_time, field, want, got);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Function to generate a random trace of up to DIFFTEST_MAX_ROWS rows, with idle gaps now and then
+int difftest_generate(uint64_t *state, bool repeated_pids, bool deadlines, Difftest_Row trace[]) {
+    int n = 1 + (int)(random_next(state) % DIFFTEST_MAX_ROWS);
+    int pids = repeated_pids ? 1 + (int)(random_next(state) % n) : n;
+    int time = 0;
+    for (int i = 0; i < n; i++) {
+        if (random_next(state) % 8 == 0) {
+            time += (int)(random_next(state) % 30);  // Idle gap
+        } else {
+            time += (int)(random_next(state) % 4);
+        }
+        trace[i].pid = 1 + i;
+        trace[i].arrival = time;
+        trace[i].burst = 1 + (int)(random_next(state) % 12);
+        trace[i].ttfr = (int)(random_next(state) % (trace[i].burst + 1));
+        trace[i].deadline = 0;
+        trace[i].has_deadline = false;
+        if (deadlines) {
+            // Mostly small deadlines so that they tie and get missed; one row in eight has none
+            int kind = (int)(random_next(state) % 8);
+            trace[i].has_deadline = (kind != 0);
+            trace[i].deadline = (kind == 1) ? -1 - (int)(random_next(state) % 5) : (int)(random_next(state) % 40);
+        }
+    }
+    if (repeated_pids) {
+        for (int i = 0; i < n; i++) {
+            trace[i].pid = 1 + (int)(random_next(state) % pids);
+        }
+    } else {
+        // Unique pids in random order, so the pid order differs from the arrival order
+        for (int i = n - 1; i > 0; i--) {
+            int j = (int)(random_next(state) % (i + 1));
+            int pid = trace[i].pid;
+            trace[i].pid = trace[j].pid;
+            trace[j].pid = pid;
+        }
+    }
+    return n;
+}
+
+// Function to shrink a failing trace while it keeps failing; returns the new row count
+int difftest_shrink(const Difftest_Engine *engine, const char *algorithm, float parameter,
+                    Difftest_Row trace[], int n) {
+    char difference[160];
+    Difftest_Row candidate[DIFFTEST_MAX_ROWS];
+    bool changed = true;
+
+    while (changed) {
+        changed = false;
+
+        // Drop runs of rows, halving the run length down to single rows
+        for (int chunk = n / 2; chunk >= 1; chunk /= 2) {
+            for (int first = 0; first + chunk <= n && n > 1; ) {
+                int m = 0;
+                for (int i = 0; i < n; i++) {
+                    if (i < first || i >= first + chunk) candidate[m++] = trace[i];
+                }
+                if (m > 0 && !difftest_case(engine, algorithm, parameter, candidate, m, difference, sizeof(difference))) {
+                    memcpy(trace, candidate, m * sizeof(Difftest_Row));
+                    n = m;
+                    changed = true;
+                } else {
+                    first += chunk;
+                }
+            }
+        }
+
+        // Lower each value: bursts and arrivals towards 1 and 0, response points to 0
+        for (int i = 0; i < n; i++) {
+            for (int field = 0; field < 3; field++) {
+                while (true) {
+                    memcpy(candidate, trace, n * sizeof(Difftest_Row));
+                    Difftest_Row *row = &candidate[i];
+                    if (field == 0 && row->burst > 1) row->burst--;
+                    else if (field == 1 && row->arrival > 0) row->arrival--;
+                    else if (field == 2 && row->ttfr > 0) row->ttfr--;
+                    else break;
+                    if (row->ttfr > row->burst) row->ttfr = row->burst;
+                    if (difftest_case(engine, algorithm, parameter, candidate, n, difference, sizeof(difference))) break;
+                    memcpy(trace, candidate, n * sizeof(Difftest_Row));
+                    changed = true;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// Function to check that MLFQ runs with every level count it accepts and the default quanta
+bool difftest_mlfq_levels(void) {
+    Difftest_Row trace[DIFFTEST_MAX_ROWS];
+    Process_For_Sim rows[DIFFTEST_MAX_ROWS];
+    uint64_t state = 1;
+    int n = difftest_generate(&state, false, false, trace);
+    for (int levels = 1; levels <= MLFQ_MAX_LEVELS; levels++) {
+        char parameter[16], error[160];
+        snprintf(parameter, sizeof(parameter), "%d", levels);
+        difftest_load_rows(trace, n, rows);
+        if (!simulate_algorithm_rows("MLFQ", parameter, -1, rows, n, error, sizeof(error))) {
+            printf("FAIL MLFQ %d levels: %s\n", levels, error);
+            return false;
+        }
+        for (int i = 0; i < n; i++) {
+            if (rows[i].remaining_time != 0) {
+                printf("FAIL MLFQ %d levels: pid %d did not finish\n", levels, rows[i].process_id);
+                return false;
+            }
+        }
+    }
+    printf("ok   MLFQ 1..%d levels with the default quanta\n", MLFQ_MAX_LEVELS);
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    int cases = (argc > 1) ? atoi(argv[1]) : 2000;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+    sequence_output_enabled = false;
+
+    int failures = difftest_mlfq_levels() ? 0 : 1;
+    int engine_count = (int)(sizeof(difftest_engines) / sizeof(difftest_engines[0]));
+    int algorithm_count = (int)(sizeof(difftest_algorithms) / sizeof(difftest_algorithms[0]));
+
+    for (int e = 0; e < engine_count; e++) {
+        const Difftest_Engine *engine = &difftest_engines[e];
+        for (int a = 0; a < algorithm_count; a++) {
+            const char *algorithm = difftest_algorithms[a];
+            if (engine->skip != NULL && strcmp(engine->skip, algorithm) == 0) {
+                continue;
+            }
+            uint64_t state = seed;
+            bool passed = true;
+
+            for (int c = 0; c < cases && passed; c++) {
+                Difftest_Row trace[DIFFTEST_MAX_ROWS];
+                int n = difftest_generate(&state, engine->repeated_pids, strcmp(algorithm, "EDF") == 0, trace);
+
+                // RR gets a quantum of 1..6, SRT an alpha in steps of 1/8
+                float parameter = 0;
+                if (strcmp(algorithm, "RR") == 0) parameter = (float)(1 + random_next(&state) % 6);
+                if (strcmp(algorithm, "SRT") == 0) parameter = (float)(random_next(&state) % 9) / 8;
+
+                char difference[160];
+                if (difftest_case(engine, algorithm, parameter, trace, n, difference, sizeof(difference))) {
+                    continue;
+                }
+                passed = false;
+                failures++;
+
+                n = difftest_shrink(engine, algorithm, parameter, trace, n);
+                difftest_case(engine, algorithm, parameter, trace, n, difference, sizeof(difference));
+                printf("FAIL %s %s %g (case %d, seed %llu): %s\n", engine->name, algorithm, parameter,
+                       c, (unsigned long long)seed, difference);
+                printf("Pid,Arrival Time,Time until first Response,Burst Length\n");
+                for (int i = 0; i < n; i++) {
+                    printf("%d,%d,%d,%d", trace[i].pid, trace[i].arrival, trace[i].ttfr, trace[i].burst);
+                    if (trace[i].has_deadline) printf(",%d", trace[i].deadline);
+                    printf("\n");
+                }
+            }
+            if (passed) {
+                printf("ok   %s %s (%d traces)\n", engine->name, algorithm, cases);
+            }
+        }
+    }
+    return (failures > 0) ? 1 : 0;
+}
+
+#endif
+
+#ifdef SCHED_BENCHMARK
+
+// Event-queue benchmark
+//
+// Built with -DSCHED_BENCHMARK this file has a main that times the timing
+// wheel against the binary heap it replaced as the multi-burst engine's
+// blocked queue. Each run is a hold model: the queue holds a fixed number of
+// pending wake-ups, and every step expires all the earliest ones the way the
+// engine does, scheduling a new wake-up for each a delay after the current
+// time. The delays follow the shapes of our traces:
+//
+//     quantum   1..8 ticks, RR quanta and short bursts
+//     io        100..150 ticks, a fixed I/O time plus the burst before it
+//     horizon   1..1000000 ticks, arrivals spread over a very long trace
+//     bursty    mostly 0..3 ticks, with one in ten 10000..100000 ticks ahead
+//
+// Both queues see the same multiset of times, so their checksums must match.
+//
+//     gcc -O2 -pthread -DSCHED_BENCHMARK -o scheduler_benchmark schedulerFile.c -lm
+//     ./scheduler_benchmark [steps] [seed]
+
+typedef struct {
+    const char *name;
+    uint64_t (*delay)(uint64_t *state);
+} Benchmark_Shape;
+
+uint64_t benchmark_quantum_delay(uint64_t *state) {
+    return 1 + random_next(state) % 8;
+}
+
+uint64_t benchmark_io_delay(uint64_t *state) {
+    return 100 + random_next(state) % 51;
+}
+
+uint64_t benchmark_horizon_delay(uint64_t *state) {
+    return 1 + random_next(state) % 1000000;
+}
+
+uint64_t benchmark_bursty_delay(uint64_t *state) {
+    uint64_t draw = random_next(state);
+    return (draw % 10 == 0) ? 10000 + (draw >> 8) % 90001 : (draw >> 8) % 4;
+}
+
+const Benchmark_Shape benchmark_shapes[] = {
+    {"quantum", benchmark_quantum_delay},
+    {"io", benchmark_io_delay},
+    {"horizon", benchmark_horizon_delay},
+    {"bursty", benchmark_bursty_delay},
+};
+
+// Function to return the seconds since an arbitrary start
+double benchmark_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Function to run steps hold-model steps with pending wake-ups on a heap or a wheel;
+// returns the seconds taken and leaves a checksum of the expired times
+double benchmark_run(const Benchmark_Shape *shape, int pending, long long steps, uint64_t seed, bool wheel,
+                     uint64_t *checksum) {
+    uint64_t *time = (uint64_t *)malloc(pending * sizeof(uint64_t));
+    int *links = (int *)malloc(pending * sizeof(int));
+    int *due = (int *)malloc(pending * sizeof(int));
+    if (time == NULL || links == NULL || due == NULL) {
+        printf("Memory allocation failed\n");
+        exit(1);
+    }
+    Index_Heap heap = heap_create(pending, time);
+    Timing_Wheel timing_wheel;
+    wheel_init(&timing_wheel);
+    timing_wheel.time = time;
+    timing_wheel.next = links;
+
+    uint64_t state = seed;
+    for (int i = 0; i < pending; i++) {
+        time[i] = shape->delay(&state);
+        if (wheel) wheel_insert(&timing_wheel, i);
+        else heap_push(&heap, i);
+    }
+
+    *checksum = 0;
+    double start = benchmark_seconds();
+    for (long long step = 0; step < steps;) {
+        // Expire everything due at the earliest time, then schedule each again
+        uint64_t now = wheel ? wheel_earliest(&timing_wheel) : time[heap.items[0]];
+        int count = 0;
+        if (wheel) {
+            int i;
+            while ((i = wheel_pop(&timing_wheel, now)) != -1) due[count++] = i;
+        } else {
+            while (heap.size > 0 && time[heap.items[0]] <= now) due[count++] = heap_pop(&heap);
+        }
+        for (int k = 0; k < count; k++) {
+            *checksum += now;
+            time[due[k]] = now + shape->delay(&state);
+            if (wheel) wheel_insert(&timing_wheel, due[k]);
+            else heap_push(&heap, due[k]);
+        }
+        step += count;
+    }
+    double seconds = benchmark_seconds() - start;
+
+    free(time);
+    free(links);
+    free(due);
+    free(heap.items);
+    return seconds;
+}
+
+int main(int argc, char *argv[]) {
+    long long steps = (argc > 1) ? atoll(argv[1]) : 2000000;
+    uint64_t seed = (argc > 2) ? strtoull(argv[2], NULL, 10) : 1;
+    const int sizes[] = {1000, 100000, 1000000};
+    int failures = 0;
+
+    printf("%-8s %9s %12s %12s %8s\n", "shape", "pending", "heap ns/op", "wheel ns/op", "speedup");
+    for (size_t s = 0; s < sizeof(benchmark_shapes) / sizeof(benchmark_shapes[0]); s++) {
+        for (size_t z = 0; z < sizeof(sizes) / sizeof(sizes[0]); z++) {
+            uint64_t heap_checksum, wheel_checksum;
+            double heap_seconds = benchmark_run(&benchmark_shapes[s], sizes[z], steps, seed, false, &heap_checksum);
+            double wheel_seconds = benchmark_run(&benchmark_shapes[s], sizes[z], steps, seed, true, &wheel_checksum);
+            printf("%-8s %9d %12.1f %12.1f %7.2fx%s\n", benchmark_shapes[s].name, sizes[z], heap_seconds * 1e9 / steps,
+                   wheel_seconds * 1e9 / steps, heap_seconds / wheel_seconds,
+                   (heap_checksum == wheel_checksum) ? "" : "  CHECKSUM MISMATCH");
+            if (heap_checksum != wheel_checksum) failures++;
+        }
+    }
+    return (failures > 0) ? 1 : 0;
+}
+
+#endif